@@ -0,0 +1,118 @@
+#include "hal.h"
+#include "classifier.h"
+#include "structures.h"
+
+#define HUE_WEIGHT 145        // 8.8 weight mapping half a hue circle (1800) to ~1024
+#define NORM_MAX 0x3FFF       // clamp for normalised channels so a 4 channel sum fits 16 bits
+
+/************************************************
+ *  Function to precompute the classifier from the calibration data
+ *  Each S/V/C channel is weighted so its spread across the 9 cards maps to ~1024,
+ *  hue uses a fixed weight as it is compared around the circle
+ ***********************************************/
+void classifier_train(CLASSIFIER *cl, HSV *cal) {
+    // find the spread of each channel across the calibration cards
+    for (unsigned char k = 1; k < 4; k++) {
+        unsigned int min = 0xFFFF, max = 0;
+        for (unsigned char i = 0; i < 9; i++) {
+            unsigned int x = classifier_channel(&cal[i], k);
+            if (x < min) {min = x;}
+            if (x > max) {max = x;}
+        }
+        unsigned int range = max - min < 64 ? 64 : max - min;  // avoid huge weights for flat channels
+        cl->weight[k] = (unsigned int)(262144UL / range);      // 8.8 weight: range -> 1024
+        cl->offset[k] = (long)min - range;                     // centroids land in 1024..2048
+    }
+    cl->weight[0] = HUE_WEIGHT;
+    cl->offset[0] = 0;
+    cl->hueCircle = (unsigned int)((3600UL * HUE_WEIGHT) >> 8);
+
+    // store the normalised centroid of each card
+    for (unsigned char i = 0; i < 9; i++) {
+        for (unsigned char k = 0; k < 4; k++) {
+            cl->cent[i][k] = classifier_normalise(cl, classifier_channel(&cal[i], k), k);
+        }
+    }
+
+    // find the distance from each centroid to its nearest neighbour for early exit
+    for (unsigned char i = 0; i < 9; i++) {
+        cl->nearest[i] = 0xFFFF;
+        for (unsigned char j = 0; j < 9; j++) {
+            if (i == j) {continue;}
+            unsigned int d = classifier_distance(cl, cl->cent[i], cl->cent[j], 0xFFFF);
+            if (d < cl->nearest[i]) {cl->nearest[i] = d;}
+        }
+    }
+}
+
+/************************************************
+ *  Function to return channel k of a HSVC reading (0: h, 1: s, 2: v, 3: c)
+ ***********************************************/
+unsigned int classifier_channel(HSV *hsv, unsigned char k) {
+    switch (k) {
+        case 0:  return hsv->h;
+        case 1:  return hsv->s;
+        case 2:  return hsv->v;
+        default: return hsv->c;
+    }
+}
+
+/************************************************
+ *  Function to normalise channel k of a HSVC reading (0: h, 1: s, 2: v, 3: c)
+ ***********************************************/
+unsigned int classifier_normalise(CLASSIFIER *cl, unsigned int x, unsigned char k) {
+    long v = (long)x - cl->offset[k];
+    if (v < 0) {return 0;}
+    unsigned long n = ((unsigned long)v * cl->weight[k]) >> 8;
+    return n > NORM_MAX ? NORM_MAX : (unsigned int)n;
+}
+
+/************************************************
+ *  Function to return the weighted L1 distance between two normalised readings
+ *  Hue is compared around the circle, so 3590 and 10 are close
+ *  Stops accumulating once the distance reaches 'limit'
+ ***********************************************/
+unsigned int classifier_distance(CLASSIFIER *cl, unsigned int *a, unsigned int *b, unsigned int limit) {
+    unsigned int d = a[0] > b[0] ? a[0] - b[0] : b[0] - a[0];
+    if (d > cl->hueCircle / 2) {d = cl->hueCircle - d;}  // circular hue difference
+
+    for (unsigned char k = 1; k < 4 && d < limit; k++) {
+        d += a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+    }
+    return d;
+}
+
+/************************************************
+ *  Function to return the index of the calibration card closest to 'hsv'
+ *  'margin' receives a lower bound on how much further the runner up is than the winner
+ *  A card closer than half the distance to its nearest neighbour is the winner
+ *  by the triangle inequality, so the search stops there
+ ***********************************************/
+unsigned char classifier_match(CLASSIFIER *cl, HSV *hsv, unsigned int *margin) {
+    unsigned int x[4];
+    for (unsigned char k = 0; k < 4; k++) {
+        x[k] = classifier_normalise(cl, classifier_channel(hsv, k), k);
+    }
+
+    unsigned char decision = 9;
+    unsigned int best = 0xFFFF, second = 0xFFFF;
+
+    for (unsigned char i = 0; i < 9; i++) {
+        unsigned int d = classifier_distance(cl, x, cl->cent[i], second);  // give up once it cannot place
+        if (d < best) {
+            second = best;
+            best = d;
+            decision = i;
+
+            if (best < cl->nearest[i] / 2) {
+                *margin = cl->nearest[i] - 2 * best;  // every other card is at least this much further away
+                return decision;
+            }
+        } else if (d < second) {
+            second = d;
+        }
+    }
+
+    *margin = second - best;
+    return decision;
+}
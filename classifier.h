@@ -0,0 +1,15 @@
+#ifndef _classifier_H
+#define _classifier_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+void classifier_train(CLASSIFIER *cl, HSV *cal);
+unsigned int classifier_channel(HSV *hsv, unsigned char k);
+unsigned int classifier_normalise(CLASSIFIER *cl, unsigned int x, unsigned char k);
+unsigned int classifier_distance(CLASSIFIER *cl, unsigned int *a, unsigned int *b, unsigned int limit);
+unsigned char classifier_match(CLASSIFIER *cl, HSV *hsv, unsigned int *margin);
+
+#endif
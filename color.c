@@ -1,9 +1,54 @@
-#include <xc.h>
+#include "hal.h"
+#include "classifier.h"
 #include "color.h"
 #include "dc_motor.h"
+#include "eeprom.h"
+#include "filter.h"
 #include "hardware.h"
 #include "i2c.h"
+#include "profile.h"
 #include "structures.h"
+#include "timers.h"
+
+static unsigned char sampleBuf[2][8];          // double buffer for background RGBC samples
+static volatile unsigned char sampleFront = 0; // index of the buffer holding the latest complete sample
+static volatile unsigned char sampleBusy = 0;  // set while a background sample is in flight
+static volatile unsigned char sampleFresh = 0; // set when a new sample has arrived
+static volatile unsigned char sampleSeq = 0;   // sequence number of the latest complete sample
+static unsigned char sampleStatus;             // STATUS register read by the background sampler
+static unsigned char sampleClear;              // dummy buffer for the interrupt clear command
+static volatile unsigned char sampleSkip = 0;  // set to drop the next sample after a settings change
+
+static unsigned char votes[10];                // number of votes for each color (index 9 is no decision)
+static unsigned char voteLeader;               // color with the most votes so far
+static unsigned char voteCount;                // readings used for the current card
+
+// reciprocal table for hueRatio(): round(600 * 8192 / d) for d = 128..255
+static const unsigned int hueRecip[128] = {
+    38400, 38102, 37809, 37521, 37236, 36956, 36681, 36409,
+    36141, 35877, 35617, 35361, 35109, 34860, 34614, 34372,
+    34133, 33898, 33666, 33437, 33211, 32988, 32768, 32551,
+    32337, 32125, 31917, 31711, 31508, 31307, 31109, 30913,
+    30720, 30529, 30341, 30155, 29971, 29789, 29610, 29432,
+    29257, 29084, 28913, 28744, 28577, 28412, 28248, 28087,
+    27927, 27769, 27613, 27459, 27307, 27156, 27007, 26859,
+    26713, 26569, 26426, 26284, 26145, 26006, 25869, 25734,
+    25600, 25467, 25336, 25206, 25078, 24950, 24824, 24699,
+    24576, 24454, 24333, 24213, 24094, 23977, 23860, 23745,
+    23631, 23518, 23406, 23295, 23185, 23076, 22968, 22861,
+    22756, 22651, 22547, 22444, 22342, 22241, 22141, 22041,
+    21943, 21845, 21749, 21653, 21558, 21464, 21370, 21278,
+    21186, 21095, 21005, 20916, 20827, 20739, 20652, 20566,
+    20480, 20395, 20311, 20227, 20144, 20062, 19980, 19900,
+    19819, 19740, 19661, 19582, 19505, 19428, 19351, 19275
+};
+
+static const unsigned char profileAtime[2] = {0xF6, 0xD5}; // integration time per profile (24ms, 103ms)
+static const unsigned char profileGain[2] = {2, 0};        // default AGAIN per profile (16x, 1x)
+static const unsigned char gainMult[4] = {1, 4, 16, 60};   // gain multiplier for each AGAIN setting
+static unsigned char profile = COLOR_PROFILE_CLASSIFY;     // active sensor profile
+static unsigned char atime = 0xD5;                          // active ATIME register value
+static unsigned char gain = 0;                              // active AGAIN register value
 
 /************************************************
  *  Function to initialise the colour click module using I2C
@@ -16,11 +61,15 @@ void color_click_init(void) {
 	 color_writetoaddr(0x00, 0x01);
     __delay_ms(3);        // need to wait 3 ms for everything to start up
     
-    // turn on device ADC
-	color_writetoaddr(0x00, 0x03);
+    // turn on device ADC and the RGBC interrupt (flags each completed integration in STATUS)
+	color_writetoaddr(0x00, 0x13);
 
-    // set integration time
+    // set integration time and gain for the classify profile
 	color_writetoaddr(0x01, 0xD5);   
+	color_writetoaddr(0x0F, 0x00);   
+
+    // set persistence so every RGBC cycle raises the interrupt flag
+	color_writetoaddr(0x0C, 0x00);
 }
 
 /************************************************
@@ -29,11 +78,15 @@ void color_click_init(void) {
  *	'value' is the value that will be written to that address
  ***********************************************/
 void color_writetoaddr(char address, char value) {
-    I2C_2_Master_Start();                // start condition
-    I2C_2_Master_Write(0x52 | 0x00);     // 7 bit device address + Write mode
-    I2C_2_Master_Write(0x80 | address);  // command + register address
-    I2C_2_Master_Write(value);    
-    I2C_2_Master_Stop();                 // stop condition
+    I2C_XFER xfer;
+    xfer.address = 0x52;                 // 7 bit device address
+    xfer.command = 0x80 | address;       // command + register address
+    xfer.data = (unsigned char *)&value; // single data byte to write
+    xfer.length = 1;
+    xfer.read = 0;                       // write transaction
+    xfer.done = 0;
+    xfer.callback = 0;
+    I2C_2_Master_Transfer(&xfer);        // queue and wait for completion
 }
 
 /************************************************
@@ -42,16 +95,254 @@ void color_writetoaddr(char address, char value) {
  *	Returns a 16 bit ADC value representing colour intensity
  ***********************************************/
 unsigned int color_read(char address) {
-	unsigned int tmp;
-	I2C_2_Master_Start();                 // start condition
-	I2C_2_Master_Write(0x52 | 0x00);      // 7 bit address + Write mode
-	I2C_2_Master_Write(0xA0 | address);   // command (auto-increment protocol transaction) + start at COLOR low register
-	I2C_2_Master_RepStart();		      // start a repeated transmission
-	I2C_2_Master_Write(0x52 | 0x01);      // 7 bit address + Read (1) mode
-	tmp=I2C_2_Master_Read(1);		      // read the COLOR LSB
-	tmp=tmp | (I2C_2_Master_Read(0)<<8);  // read the COLOR MSB (don't acknowledge as this is the last read)
-	I2C_2_Master_Stop();                  // stop condition
-	return tmp;
+    unsigned char buf[2];                // COLOR LSB and MSB
+    I2C_XFER xfer;
+    xfer.address = 0x52;                 // 7 bit device address
+    xfer.command = 0xA0 | address;       // command (auto-increment protocol transaction) + start at COLOR low register
+    xfer.data = buf;
+    xfer.length = 2;
+    xfer.read = 1;                       // read transaction
+    xfer.done = 0;
+    xfer.callback = 0;
+    I2C_2_Master_Transfer(&xfer);        // queue and wait for completion
+    return buf[0] | (unsigned int)buf[1] << 8;
+}
+
+/************************************************
+ *  Function to convert a raw 8 byte RGBC burst into an RGB structure
+ *  Bytes are in order: CLEAR, RED, GREEN, BLUE (LSB then MSB for each channel)
+ ***********************************************/
+RGB color_unpack(unsigned char *buf) {
+    RGB rgb;
+    rgb.c = buf[0] | (unsigned int)buf[1] << 8;
+    rgb.r = buf[2] | (unsigned int)buf[3] << 8;
+    rgb.g = buf[4] | (unsigned int)buf[5] << 8;
+    rgb.b = buf[6] | (unsigned int)buf[7] << 8;
+    return rgb;
+}
+
+/************************************************
+ *  Function to read all four colour channels in a single transaction
+ *  Auto-increment starts at CDATA (0x14) and reads the 8 data bytes
+ ***********************************************/
+RGB color_read_block(void) {
+    unsigned char buf[8];                // raw RGBC burst
+    I2C_XFER xfer;
+    xfer.address = 0x52;                 // 7 bit device address
+    xfer.command = 0xA0 | 0x14;          // command (auto-increment protocol transaction) + start at CDATA low register
+    xfer.data = buf;
+    xfer.length = 8;
+    xfer.read = 1;                       // read transaction
+    xfer.done = 0;
+    xfer.callback = 0;
+    I2C_2_Master_Transfer(&xfer);        // queue and wait for completion
+    return color_unpack(buf);
+}
+
+/************************************************
+ *  Function called by the I2C engine when a background sample completes
+ *  Swaps the double buffer so the new sample becomes the latest one
+ ***********************************************/
+void color_sample_done(void) {
+    if (I2C_2_Master_Failed()) {         // not acknowledged, the back buffer holds no sample
+        sampleBusy = 0;
+        return;
+    }
+    if (sampleSkip) {                    // drop the sample and keep the previous one
+        sampleSkip = 0;
+        sampleBusy = 0;
+        return;
+    }
+    sampleFront = !sampleFront;          // the back buffer now holds the latest sample
+    sampleSeq++;
+    sampleBusy = 0;
+    sampleFresh = 1;
+}
+
+/************************************************
+ *  Function called by the I2C engine when the STATUS register has been read
+ *  Only fetches the colour data if a new integration has completed (AINT set)
+ *  The interrupt clear and the data read are queued together or not at all,
+ *  so AINT is never cleared for a sample that is then not read
+ ***********************************************/
+void color_status_done(void) {
+    if (I2C_2_Master_Failed() || !(sampleStatus & 0x10)) {  // STATUS not read, or no new integration since the last sample
+        sampleBusy = 0;
+        return;
+    }
+
+    I2C_XFER xfer[2];
+    xfer[0].address = 0x52;              // 7 bit device address
+    xfer[0].command = 0xE6;              // special function: clear RGBC interrupt
+    xfer[0].data = &sampleClear;
+    xfer[0].length = 0;                  // command only
+    xfer[0].read = 0;
+    xfer[0].done = 0;
+    xfer[0].callback = 0;
+
+    xfer[1].address = 0x52;
+    xfer[1].command = 0xA0 | 0x14;       // command (auto-increment protocol transaction) + start at CDATA low register
+    xfer[1].data = sampleBuf[!sampleFront];  // read into the back buffer
+    xfer[1].length = 8;
+    xfer[1].read = 1;                    // read transaction
+    xfer[1].done = 0;
+    xfer[1].callback = color_sample_done;    // swap buffers on completion
+
+    if (!I2C_2_Master_QueueAll(xfer, 2)) {sampleBusy = 0;}  // AINT stays set, so the next check retries
+}
+
+/************************************************
+ *  Function to start a background check for a new colour sample
+ *  Reads STATUS first and only reads the colour channels when a fresh integration is available
+ *  Returns 1 if a check was queued, 0 if one is already in flight or the queue is full
+ ***********************************************/
+unsigned char color_start_sample(void) {
+    if (sampleBusy) {return 0;}
+
+    I2C_XFER xfer;
+    xfer.address = 0x52;                 // 7 bit device address
+    xfer.command = 0xA0 | 0x13;          // command + STATUS register
+    xfer.data = &sampleStatus;
+    xfer.length = 1;
+    xfer.read = 1;                       // read transaction
+    xfer.done = 0;
+    xfer.callback = color_status_done;   // fetch the data if a new integration is ready
+
+    sampleBusy = 1;
+    if (!I2C_2_Master_Queue(&xfer)) {
+        sampleBusy = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/************************************************
+ *  Function to check if a new background sample has completed
+ *  1: a sample has arrived since the last call to color_latest
+ *  0: no new sample
+ ***********************************************/
+unsigned char color_sample_ready(void) {
+    return sampleFresh;
+}
+
+/************************************************
+ *  Function to return the latest completed background sample
+ ***********************************************/
+RGB color_latest(void) {
+    sampleFresh = 0;
+    return color_unpack(sampleBuf[sampleFront]);
+}
+
+/************************************************
+ *  Function to return the sequence number of the latest background sample
+ *  Increments once per completed sensor integration
+ ***********************************************/
+unsigned char color_sample_seq(void) {
+    return sampleSeq;
+}
+
+/************************************************
+ *  Function to wait for the next fresh background sample and return it
+ ***********************************************/
+RGB color_wait_sample(void) {
+    while (!color_sample_ready()) {
+        color_start_sample();            // keep checking for a completed integration
+        I2C_2_Master_Poll();
+    }
+    return color_latest();
+}
+
+/************************************************
+ *  Function to apply an integration time and gain to the sensor
+ *  The sample in progress during the change is dropped
+ ***********************************************/
+void color_apply(unsigned char newAtime, unsigned char newGain) {
+    unsigned long deadline = getTicks() + I2C_TIMEOUT;
+    while (sampleBusy) {                 // let any background sample finish
+        I2C_2_Master_Poll();
+        if (deadlineReached(deadline)) {I2C_2_Master_Abort();}  // stuck bus, the sample fails and is dropped
+    }
+
+    atime = newAtime;
+    gain = newGain;
+    color_writetoaddr(0x01, atime);      // set integration time
+    color_writetoaddr(0x0F, gain);       // set AGAIN in the CONTROL register
+
+    I2C_XFER xfer;
+    xfer.address = 0x52;                 // 7 bit device address
+    xfer.command = 0xE6;                 // special function: clear RGBC interrupt
+    xfer.data = &sampleClear;
+    xfer.length = 0;                     // command only
+    xfer.read = 0;
+    xfer.done = 0;
+    xfer.callback = 0;
+    I2C_2_Master_Transfer(&xfer);        // only integrations finishing after the change are flagged
+
+    sampleFresh = 0;                     // discard samples taken with the old settings
+    sampleSkip = 1;                      // and the integration that straddled the change
+}
+
+/************************************************
+ *  Function to switch the sensor profile
+ *  COLOR_PROFILE_APPROACH: short integration, high gain for wall detection
+ *  COLOR_PROFILE_CLASSIFY: long integration, unity gain for card classification
+ ***********************************************/
+void color_set_profile(unsigned char newProfile) {
+    if (newProfile == profile) {return;}
+    profile = newProfile;
+    color_apply(profileAtime[profile], profileGain[profile]);
+}
+
+/************************************************
+ *  Function to choose a gain that keeps the clear channel within range
+ *  Only used for the approach profile, as calibration relies on a fixed classify gain
+ ***********************************************/
+void color_autorange(void) {
+    unsigned char cycles = 256 - atime;
+    unsigned int max = cycles >= 64 ? 65535 : (unsigned int)cycles * 1024;  // full scale clear count
+
+    for (unsigned char i = 0; i < 3; i++) {
+        RGB rgb = color_wait_sample();
+        if (rgb.c > max - max/5 && gain > 0) {
+            color_apply(atime, gain - 1);    // close to saturation, reduce the gain
+        } else if (rgb.c < max/10 && gain < 3) {
+            color_apply(atime, gain + 1);    // poor resolution, increase the gain
+        } else {
+            break;
+        }
+    }
+}
+
+/************************************************
+ *  Function to scale a clear channel count measured with the classify profile
+ *  to the equivalent count for the active integration time and gain
+ ***********************************************/
+unsigned int color_scale(unsigned int counts) {
+    unsigned long scaled = (unsigned long)counts * (unsigned char)(256 - atime) * gainMult[gain];
+    return scaled / ((unsigned char)(256 - profileAtime[COLOR_PROFILE_CLASSIFY]) * gainMult[profileGain[COLOR_PROFILE_CLASSIFY]]);
+}
+
+/************************************************
+ *  Function to return 600 * num / diff, rounded, without a division
+ *  diff is normalised into 128..255 for a reciprocal from hueRecip[], which
+ *  estimates the ratio to within a few units once diff has had to be shifted
+ *  down. The remainder of the estimate then steps it to the exact rounded
+ *  quotient. Requires num <= diff and diff > 0.
+ *  sim/bench_hue.c checks every num and diff against (600 * num + diff / 2) / diff
+ ***********************************************/
+unsigned int hueRatio(unsigned int num, unsigned int diff) {
+    unsigned int d = diff;
+    unsigned long n = num;
+    unsigned char shift = 13;                   // drops the 2^13 scaling of the table
+    while (d > 255) {d >>= 1; shift++;}         // num is kept whole, the shift is taken from the product
+    while (d < 128) {d <<= 1; n <<= 1;}
+    unsigned int q = (n * hueRecip[d - 128]) >> shift;
+    
+    // remainder of the rounded quotient, at most a few diff out either way
+    long r = (long)num * 600 + (diff >> 1) - (long)q * diff;
+    while (r < 0) {q--; r += diff;}
+    while (r >= (long)diff) {q++; r -= diff;}
+    return q;
 }
 
 /************************************************
@@ -60,6 +351,7 @@ unsigned int color_read(char address) {
  *  but as the RGB data is not normalised this is not true HSV
  ***********************************************/
 HSV rgb2hsv(struct RGB rgb) {
+    PROF_START(PROF_RGB2HSV);
     HSV hsv;                            // declare structure to return HSV values
     hsv.c = rgb.c;                      // assign clear value to clear channel reading
     unsigned int rgbMin, rgbMax, diff;  // initialise variables to store them as unsigned int
@@ -78,45 +370,28 @@ HSV rgb2hsv(struct RGB rgb) {
         hsv.s = diff;
     }
 
-    // logic to find the Hue scaled to 3600
+    // logic to find the Hue scaled to 3600, each sector is offset by +/- 600 * ratio
     if (!diff) {
         hsv.h = 0;
     } else if (rgb.r == rgbMax) {
-        hsv.h = (3600 + 600 * (rgb.g - rgb.b) / diff) % 3600;
+        hsv.h = rgb.g >= rgb.b ? hueRatio(rgb.g - rgb.b, diff) : 3600 - hueRatio(rgb.b - rgb.g, diff);
+        if (hsv.h >= 3600) {hsv.h = 0;}
     } else if (rgb.g == rgbMax) {
-        hsv.h = (1200 + 600 * (rgb.b - rgb.r) / diff) % 3600;
+        hsv.h = rgb.b >= rgb.r ? 1200 + hueRatio(rgb.b - rgb.r, diff) : 1200 - hueRatio(rgb.r - rgb.b, diff);
     } else {
-        hsv.h = (2400 + 600 * (rgb.r - rgb.g) / diff) % 3600;
+        hsv.h = rgb.r >= rgb.g ? 2400 + hueRatio(rgb.r - rgb.g, diff) : 2400 - hueRatio(rgb.g - rgb.r, diff);
     }
 
+    PROF_END(PROF_RGB2HSV);
     return hsv;
 }
 
-/************************************************
- *  Function to return the RGB sensor data as an RGB structure
- ***********************************************/
-RGB getRGB(void) {
-    RGB rgb;                   // temporary structure to return RGB values 
-    rgb.r = color_read(0x16);  // read and store red value
-    rgb.g = color_read(0x18);  // read and store green value
-    rgb.b = color_read(0x1A);  // read and store blue value
-    rgb.c = color_read(0x14);  // read and store clear value
-    
-    return rgb;
-}
-
 /************************************************
  *  Function to store the sensor data in the data structure
  ***********************************************/
 void storeColor(DATA *data) {
-    data->hsv = rgb2hsv(getRGB());  // convert and store HSV from RGB value
-}
-
-/************************************************
- *  Function to store clear channel data to data structure
- ***********************************************/
-void storeAmbient(DATA *data) {
-    data->ambLight = color_read(0x14);  // read the clear channel from sensor
+    data->rgb = color_wait_sample();  // store the next fresh RGB value
+    data->hsv = rgb2hsv(data->rgb);   // convert and store HSV
 }
 
 /************************************************
@@ -124,6 +399,7 @@ void storeAmbient(DATA *data) {
  ***********************************************/
 void storeCalibration(DATA *data) {
     unsigned char i = 0;
+    color_set_profile(COLOR_PROFILE_CLASSIFY);  // calibration must use the same profile as detection
     
     while (i < 9) {
         LED_flash(i + 1);      // flash indicators to show what color to calibrate
@@ -132,47 +408,90 @@ void storeCalibration(DATA *data) {
         LED_on();
         __delay_ms(1500);   
         
-        // store the calibration color in the data structure
-        data->cal[i] = rgb2hsv(getRGB());        
+        // store the average of a moving average window, as used by detection
+        filterReset(data->filter);
+        for (unsigned char n = 0; n < FILTER_WINDOW; n++) {
+            filterAdd(data->filter, color_wait_sample(), getTicks());
+        }
+        data->cal[i] = rgb2hsv(filterMean(data->filter));
         LED_off();
         i++;
     }   
+    
+    // precompute the normalised centroids and weights used by detectVote
+    classifier_train(data->classifier, data->cal);
+    
+    // keep the calibration so it does not need repeating after a reset
+    eepromSave(CAL_EEPROM, CAL_VERSION, (unsigned char *)data->cal, sizeof(data->cal));
 }
 
 /************************************************
- *  Function to return the numerical difference between two HSV values
+ *  Function to load the reference calibration data stored by storeCalibration
+ *  1: calibration loaded and classifier ready
+ *  0: no valid calibration stored, storeCalibration must be run
  ***********************************************/
-unsigned int hsvDiff(struct HSV h1, struct HSV h2) {
-    // find the absolute difference for each HSV component
-    unsigned int h = h1.h > h2.h ? h1.h - h2.h : h2.h - h1.h;
-    unsigned int s = h1.s > h2.s ? h1.s - h2.s : h2.s - h1.s;
-    unsigned int v = h1.v > h2.v ? h1.v - h2.v : h2.v - h1.v;
-    unsigned int c = h1.c > h2.c ? h1.c - h2.c : h2.c - h1.c;
-    
-    // obtain the sum based on the absolute difference of each channel
-    return h + s + v + c;
+unsigned char loadCalibration(DATA *data) {
+    if (!eepromLoad(CAL_EEPROM, CAL_VERSION, (unsigned char *)data->cal, sizeof(data->cal))) {return 0;}
+    classifier_train(data->classifier, data->cal);
+    return 1;
 }
 
 /************************************************
- *  Function to return an integer value based on the detected color
- *  Iterates through each color and finds the numerical difference
- *  between the detected color and calibration color and returns the lowest color
+ *  Function to start classifying a card
+ *  Selects the classification profile and clears the votes of the last card
  ***********************************************/
-unsigned char detectColor(DATA *data) {
-    storeColor(data);                 // read the color of the card/wall
+void detectStart(void) {
+    color_set_profile(COLOR_PROFILE_CLASSIFY);  // long integration for precise classification
+    for (unsigned char i = 0; i < 10; i++) {votes[i] = 0;}
+    voteLeader = 9;
+    voteCount = 0;
+}
+
+/************************************************
+ *  Function to add the color of a reading to the votes for the current card
+ *  The class and margin of the reading are stored in cls and margin.
+ *  Returns COLOR_UNDECIDED until the leading color has a confident reading or a
+ *  majority, or COLOR_VOTE_SAMPLES readings have been used, so clear cards take
+ *  one integration and only ambiguous cards take more
+ ***********************************************/
+unsigned char detectVote(CLASSIFIER *cl, HSV *hsv, unsigned char *cls, unsigned int *margin) {
+    PROF_START(PROF_DETECT);
+    PROF_START(PROF_CLASSIFY);
+    unsigned char decision = classifier_match(cl, hsv, margin);
+    PROF_END(PROF_CLASSIFY);
+    *cls = decision;
     
-    char decision = 9;                // declare a decision output variable
-    unsigned int difference = 20000;  // declare an HSV difference variable at max difference
+    votes[decision]++;
+    voteCount++;
+    if (votes[decision] > votes[voteLeader] || voteLeader == 9) {voteLeader = decision;}
     
-    // iterate through the list of calibrated value and computing the difference to determine the value with the smallest difference
-    for (char i = 0; i < 9; i++) {
-        unsigned int tmp = hsvDiff(data->hsv, data->cal[i]);
-        if (tmp < difference) {
-            difference = tmp;         // set the difference if it is smaller than the current value
-            decision = i;             // select the color with the lowest difference
-        }
-    }
+    // stop once the leader has a confident reading or an outright majority
+    unsigned char done = (decision == voteLeader && *margin >= COLOR_VOTE_MARGIN)
+        || votes[voteLeader] > COLOR_VOTE_SAMPLES/2 || voteCount >= COLOR_VOTE_SAMPLES;
+    PROF_END(PROF_DETECT);
     
-    // return the index of the best guess (smallest difference) for the buggy to perform the action
+    // return the color with the most votes for the buggy to perform the action
+    return done ? voteLeader : COLOR_UNDECIDED;
+}
+
+/************************************************
+ *  Function to return the color with the most votes for the current card,
+ *  for when the readings run out before detectVote has decided
+ ***********************************************/
+unsigned char detectLeader(void) {
+    return voteLeader == 9 ? COLOR_UNDECIDED : voteLeader;
+}
+
+/************************************************
+ *  Function to return an integer value based on the detected color
+ *  Blocks, taking fresh readings until detectVote reaches a decision
+ ***********************************************/
+unsigned char detectColor(DATA *data) {
+    unsigned char decision;
+    detectStart();
+    do {
+        storeColor(data);             // read the next fresh color of the card/wall
+        decision = detectVote(data->classifier, &data->hsv, &data->decision, &data->margin);
+    } while (decision == COLOR_UNDECIDED);
     return decision;
 }
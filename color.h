@@ -1,20 +1,42 @@
 #ifndef _color_H
 #define _color_H
 
-#include <xc.h>
+#include "hal.h"
 #include "structures.h"
 
 #define _XTAL_FREQ 64000000 // note intrinsic _delay function is 62.5ns at 64,000,000Hz  
+#define COLOR_PROFILE_APPROACH 0  // short integration, high gain for wall detection
+#define COLOR_PROFILE_CLASSIFY 1  // long integration, unity gain for card classification
+#define COLOR_VOTE_SAMPLES 5      // maximum number of readings used to classify a card
+#define COLOR_VOTE_MARGIN 256     // classifier margin for a single reading to be trusted
+#define COLOR_UNDECIDED 0xFF      // returned by detectVote until the card has been decided
+#define CAL_EEPROM 0x040          // EEPROM address of the color calibration record
+#define CAL_VERSION 1             // calibration record version, change when HSV or the profiles change
 
 void color_click_init(void);
 void color_writetoaddr(char address, char value);
 unsigned int color_read(char address);
+RGB color_unpack(unsigned char *buf);
+RGB color_read_block(void);
+void color_sample_done(void);
+void color_status_done(void);
+unsigned char color_start_sample(void);
+unsigned char color_sample_ready(void);
+RGB color_latest(void);
+unsigned char color_sample_seq(void);
+RGB color_wait_sample(void);
+void color_apply(unsigned char newAtime, unsigned char newGain);
+void color_set_profile(unsigned char newProfile);
+void color_autorange(void);
+unsigned int color_scale(unsigned int counts);
+unsigned int hueRatio(unsigned int num, unsigned int diff);
 HSV rgb2hsv(struct RGB rgb);
-RGB getRGB(void);
 void storeColor(DATA *data);
-void storeAmbient(DATA *data);
 void storeCalibration(DATA *data);
-unsigned int hsvDiff(struct HSV h1, struct HSV h2);
+unsigned char loadCalibration(DATA *data);
+void detectStart(void);
+unsigned char detectVote(CLASSIFIER *cl, HSV *hsv, unsigned char *cls, unsigned int *margin);
+unsigned char detectLeader(void);
 unsigned char detectColor(DATA *data);
 
 #endif
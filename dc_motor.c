@@ -1,17 +1,26 @@
-#include <xc.h>
+#include "hal.h"
 #include "color.h"
 #include "dc_motor.h"
+#include "eeprom.h"
 #include "hardware.h"
 #include "i2c.h"
 #include "interrupts.h"
+#include "profile.h"
 #include "sequence.h"
 #include "structures.h"
 #include "timers.h"
 
+DC_MOTOR motorL, motorR;    // declare two DC_motor structures
+TURN_TABLE turns;           // declare the calibrated turn table
+MOTOR_TRIM trim;            // declare the calibrated motor trim
+
 /************************************************
  *  Function to initialise T2 and CCP for DC motor control
+ *  The smallest prescaler that fits the period in T2PR is used, so the
+ *  10 bit duty has as many steps as possible at the requested frequency.
+ *  Frequencies below about 489Hz are clamped to the longest period
  ***********************************************/
-void initDCmotorsPWM(unsigned char PWMperiod) {
+void initDCmotorsPWM(unsigned int frequency) {
     // initialise your TRIS and LAT registers for PWM
     LATEbits.LATE2=0;       // set initial output state (RE2)
     TRISEbits.TRISE2=0;     // set TRIS value for pin (RE2)
@@ -28,22 +37,30 @@ void initDCmotorsPWM(unsigned char PWMperiod) {
     RC7PPS=0x07; // CCP3 on RC7
     RG6PPS=0x08; // CCP4 on RG6
 
+    // Tpwm*(Fosc/4)/prescaler - 1 = PTPER
+    // 0.0001s*16MHz/8 -1 = 199 at 10kHz
+    unsigned long counts = _XTAL_FREQ/4/frequency;  // timer counts per period at 1:1
+    unsigned char prescale = 0;
+    while (counts > 256 && prescale < 7) {
+        counts >>= 1;
+        prescale++;
+    }
+    if (counts > 256) {counts = 256;}   // below about 489Hz T2PR can not hold the period, run at the lowest frequency
+    unsigned int PWMperiod = counts*4;  // the duty has 4 steps per timer count (800 at 10kHz)
+
     // timer 2 config
-    T2CONbits.CKPS=0b100;   // 1:16 prescaler
+    T2CONbits.CKPS=prescale; // 1:2^prescale prescaler
     T2HLTbits.MODE=0b00000; // Free Running Mode, software gate only
     T2CLKCONbits.CS=0b0001; // Fosc/4
-
-    // Tpwm*(Fosc/4)/prescaler - 1 = PTPER
-    // 0.0001s*16MHz/16 -1 = 99
-    T2PR=PWMperiod; // Period reg 10kHz base period
+    T2PR=counts - 1;        // Period reg
     T2CONbits.ON=1;
     
     // setup CCP modules to output PMW signals
     // initial duty cycles 
-    CCPR1H=0; 
-    CCPR2H=0; 
-    CCPR3H=0; 
-    CCPR4H=0; 
+    CCPR1H=0; CCPR1L=0;
+    CCPR2H=0; CCPR2L=0;
+    CCPR3H=0; CCPR3L=0;
+    CCPR4H=0; CCPR4L=0;
     
     // use tmr2 for all CCP modules used
     CCPTMRS0bits.C1TSEL=0;
@@ -52,19 +69,19 @@ void initDCmotorsPWM(unsigned char PWMperiod) {
     CCPTMRS0bits.C4TSEL=0;
     
     // configure each CCP
-    CCP1CONbits.FMT=1;           // left aligned duty cycle (we can just use high byte)
+    CCP1CONbits.FMT=0;           // right aligned 10 bit duty cycle
     CCP1CONbits.CCP1MODE=0b1100; // PWM mode  
     CCP1CONbits.EN=1;            // turn on
     
-    CCP2CONbits.FMT=1;           // left aligned
+    CCP2CONbits.FMT=0;           // right aligned
     CCP2CONbits.CCP2MODE=0b1100; // PWM mode  
     CCP2CONbits.EN=1;            // turn on
     
-    CCP3CONbits.FMT=1;           // left aligned
+    CCP3CONbits.FMT=0;           // right aligned
     CCP3CONbits.CCP3MODE=0b1100; // PWM mode  
     CCP3CONbits.EN=1;            // turn on
     
-    CCP4CONbits.FMT=1;           // left aligned
+    CCP4CONbits.FMT=0;           // right aligned
     CCP4CONbits.CCP4MODE=0b1100; // PWM mode  
     CCP4CONbits.EN=1;            //turn on
     
@@ -72,227 +89,416 @@ void initDCmotorsPWM(unsigned char PWMperiod) {
     motorL.power=0;                                     // zero power to start
     motorL.direction=1;                                 // set default motor direction
     motorL.brakemode=1;                                 // brake mode (slow decay)
+    motorL.targetPower=0;                               // no power requested
+    motorL.targetDirection=1;                           // requested direction matches the default
+    motorL.accel=10 << POWER_SHIFT;                     // ramp up 10% per control tick
+    motorL.decel=20 << POWER_SHIFT;                     // ramp down 20% per control tick
+    motorL.posDutyLowByte=(unsigned char *)(&CCPR1L);   // store address of CCP1 duty low byte
     motorL.posDutyHighByte=(unsigned char *)(&CCPR1H);  // store address of CCP1 duty high byte
+    motorL.negDutyLowByte=(unsigned char *)(&CCPR2L);   // store address of CCP2 duty low byte
     motorL.negDutyHighByte=(unsigned char *)(&CCPR2H);  // store address of CCP2 duty high byte
-    motorL.PWMperiod=PWMperiod;                         // store PWMperiod for motor (value of T2PR in this case)
+    motorL.PWMperiod=PWMperiod;                         // store PWMperiod for motor (in duty counts)
     
     // initialise right motor values
     motorR.power=0;                                     // zero power to start
     motorR.direction=1;                                 // set default motor direction
     motorR.brakemode=1;                                 // brake mode (slow decay)
-    motorR.posDutyHighByte=(unsigned char *)(&CCPR3H);  // store address of CCP1 duty high byte
-    motorR.negDutyHighByte=(unsigned char *)(&CCPR4H);  // store address of CCP2 duty high byte
-    motorR.PWMperiod=PWMperiod;                         // store PWMperiod for motor (value of T2PR in this case)
+    motorR.targetPower=0;                               // no power requested
+    motorR.targetDirection=1;                           // requested direction matches the default
+    motorR.accel=10 << POWER_SHIFT;                     // ramp up 10% per control tick
+    motorR.decel=20 << POWER_SHIFT;                     // ramp down 20% per control tick
+    motorR.posDutyLowByte=(unsigned char *)(&CCPR3L);   // store address of CCP3 duty low byte
+    motorR.posDutyHighByte=(unsigned char *)(&CCPR3H);  // store address of CCP3 duty high byte
+    motorR.negDutyLowByte=(unsigned char *)(&CCPR4L);   // store address of CCP4 duty low byte
+    motorR.negDutyHighByte=(unsigned char *)(&CCPR4H);  // store address of CCP4 duty high byte
+    motorR.PWMperiod=PWMperiod;                         // store PWMperiod for motor (in duty counts)
+    
+    // untrimmed duty tables until the calibrated trim is loaded
+    trimDefault();
+    trimApply();
+}
+
+/************************************************
+ *  Function to build the duty lookup table of a motor for its PWMperiod
+ *  The trimmed power rises linearly from offset at power 1 to gain x 100 at full
+ *  power, so the offset trims the deadband and the gain trims the top speed
+ ***********************************************/
+void motorTable(DC_MOTOR *m, unsigned int gain, unsigned char offset) {
+    unsigned int top = ((unsigned long)gain * MOTOR_MAX) >> 8;  // trimmed full power
+    if (top > MOTOR_MAX) {top = MOTOR_MAX;}
+    if (offset > top) {offset = top;}
+    
+    m->duty[0] = 0;
+    for (unsigned char p = 1; p <= MOTOR_MAX; p++) {
+        unsigned int power = offset + ((unsigned int)p * (top - offset)) / MOTOR_MAX;
+        m->duty[p] = ((unsigned long)power * m->PWMperiod) / MOTOR_MAX;
+    }
+}
+
+/************************************************
+ *  Function to write a 10 bit duty to a right aligned CCP duty register pair
+ ***********************************************/
+static void setDuty(unsigned char *low, unsigned char *high, unsigned int duty) {
+    *high = duty >> 8;
+    *low = duty & 0xFF;
 }
 
 /************************************************
  *  Function to set CCP PWM output from the values in the motor structure
+ *  The duty is interpolated between the table entries either side of the fixed point power
  ***********************************************/
 void setMotorPWM(DC_MOTOR *m) {
-    unsigned char posDuty, negDuty; // duty cycle values for different sides of the motor
+    PROF_START(PROF_SET_PWM);
+    unsigned int posDuty, negDuty;  // duty cycle values for different sides of the motor
+    unsigned char whole = m->power >> POWER_SHIFT;
+    unsigned char frac = m->power & ((1 << POWER_SHIFT) - 1);
+    unsigned int duty = m->duty[whole];     // trimmed duty from the lookup table
+    if (frac) {
+        duty += ((unsigned long)(m->duty[whole + 1] - duty) * frac) >> POWER_SHIFT;
+    }
     
     if(m->brakemode) {
-        posDuty=m->PWMperiod - ((unsigned int)(m->power)*(m->PWMperiod))/100; // inverted PWM duty
+        posDuty=m->PWMperiod - duty; // inverted PWM duty
         negDuty=m->PWMperiod; // other side of motor is high all the time
     }
     else {
-        posDuty=((unsigned int)(m->power)*(m->PWMperiod))/100; // PWM duty
+        posDuty=duty; // PWM duty
         negDuty=0; // other side of motor is low all the time
     }
     
     if (m->direction) {
-        *(m->posDutyHighByte)=posDuty;  // assign values to the CCP duty cycle registers
-        *(m->negDutyHighByte)=negDuty;       
+        setDuty(m->posDutyLowByte, m->posDutyHighByte, posDuty);    // assign values to the CCP duty cycle registers
+        setDuty(m->negDutyLowByte, m->negDutyHighByte, negDuty);
+    } else {
+        setDuty(m->posDutyLowByte, m->posDutyHighByte, negDuty);    // do it the other way around to change direction
+        setDuty(m->negDutyLowByte, m->negDutyHighByte, posDuty);
+    }
+    PROF_END(PROF_SET_PWM);
+}
+
+/************************************************
+ *  Function to return the 8.8 fixed point power of a motor
+ *  The power is read again until it is unchanged, so the motor task
+ *  interrupt mid-read can never return a torn value
+ ***********************************************/
+unsigned int motorPower(DC_MOTOR *m) {
+    unsigned int p;
+    do {
+        p = m->power;
+    } while (p != m->power);
+    return p;
+}
+
+/************************************************
+ *  Function to set the power and direction a motor should ramp to
+ *  The ramp itself is carried out by motorTask in the timer interrupt. Whole
+ *  powers leave the low byte zero, so the interrupt can not see a torn target
+ ***********************************************/
+void setMotorTarget(DC_MOTOR *m, unsigned char direction, unsigned char power) {
+    m->targetDirection = direction;
+    m->targetPower = (unsigned int)(power > MOTOR_MAX ? MOTOR_MAX : power) << POWER_SHIFT;  // keep within the duty table
+}
+
+/************************************************
+ *  Function to step a motor towards its target by its slew rates
+ *  Power is ramped down to zero before the direction is changed
+ ***********************************************/
+void motorStep(DC_MOTOR *m) {
+    unsigned int target = m->direction == m->targetDirection ? m->targetPower : 0;
+    
+    if (m->power == target) {
+        if (m->power == 0 && m->direction != m->targetDirection) {
+            m->direction = m->targetDirection;  // stationary, safe to change direction
+            setMotorPWM(m);
+        }
+        return;
+    }
+    
+    if (m->power < target) {
+        m->power = target - m->power > m->accel ? m->power + m->accel : target;
     } else {
-        *(m->posDutyHighByte)=negDuty;  // do it the other way around to change direction
-        *(m->negDutyHighByte)=posDuty;
+        m->power = m->power - target > m->decel ? m->power - m->decel : target;
     }
+    setMotorPWM(m);
+}
+
+/************************************************
+ *  Function to run the motor control task, called from the timer interrupt every tick
+ ***********************************************/
+void motorTask(void) {
+    motorStep(&motorL);
+    motorStep(&motorR);
+}
+
+/************************************************
+ *  Function to check if both motors have reached their targets
+ *  1: both motors at target power and direction
+ *  0: still ramping
+ ***********************************************/
+unsigned char motorsSettled(void) {
+    return motorPower(&motorL) == motorL.targetPower && motorL.direction == motorL.targetDirection
+        && motorPower(&motorR) == motorR.targetPower && motorR.direction == motorR.targetDirection;
+}
+
+/************************************************
+ *  Function to wait until both motors have finished ramping
+ ***********************************************/
+void waitMotors(void) {
+    while (!motorsSettled()) {}
+}
+
+/************************************************
+ *  Function to ramp both motors down to zero without waiting
+ ***********************************************/
+void motorsStop(void) {
+    setMotorTarget(&motorL, motorL.targetDirection, 0);
+    setMotorTarget(&motorR, motorR.targetDirection, 0);
 }
 
 /************************************************
  *  Function to stop the robot gradually
  ***********************************************/
 void stop(void) {
-    // decrease the left and right motor power until it is zero
-    while (motorL.power > 0 || motorR.power > 0) {
-        if (motorL.power > 0) { motorL.power--; }
-        if (motorR.power > 0) { motorR.power--; }
-        
-        setMotorPWM(&motorL);
-        setMotorPWM(&motorR);
-        __delay_us(50);
-    }
+    motorsStop();   // ramp the left and right motor power down to zero
+    waitMotors();
 }
 
 /************************************************
  *  Function to make the robot go straight
  *  Direction: backward -> 0; forward -> 1
+ *  Returns straight away, the motors ramp to the new power in the background
  ***********************************************/
 void straight(unsigned char direction, unsigned char power) {
-    // assign direction to each motor
-    motorL.direction = direction;
-    motorR.direction = direction;
-    
-    // set motor PWM for direction change
-    setMotorPWM(&motorL);
-    setMotorPWM(&motorR);
+    setMotorTarget(&motorL, direction, power);
+    setMotorTarget(&motorR, direction, power);
+}
+
+/************************************************
+ *  Function to start the buggy rotating on the spot
+ *  Direction: left -> 0; right -> 1
+ *  Returns the full power hold time (ms) from the calibrated turn table, to
+ *  count once the motors have ramped up, or 0 if the angle is no turn
+ ***********************************************/
+unsigned int turnStart(unsigned char direction, unsigned char angle) {
+    unsigned char step = angle/45;       // 45, 90, 135 and 180 deg turns
+    if (step == 0) {return 0;}
+    if (step > 4) {step = 4;}
     
-    // gradually increase the power of the motors
-    increasePower(power);
+    setMotorTarget(&motorL, direction, TURN_POWER);
+    setMotorTarget(&motorR, !direction, TURN_POWER);
+    return turns.hold[direction][step - 1];
 }
 
 /************************************************
- *  Function to rotate the buggy
+ *  Function to rotate the buggy, waiting until the turn has finished
  *  Direction: left -> 0; right -> 1
+ *  Performs a single ramp up, hold, ramp down profile, navTask runs the
+ *  same profile without blocking
  ***********************************************/
 void rotate(unsigned char direction, unsigned char angle) {
-    // assign direction to each motor
-    motorL.direction = direction;
-    motorR.direction = !direction;
-    
-    // set motor PWM for direction change
-    setMotorPWM(&motorL);
-    setMotorPWM(&motorR);
+    unsigned int hold = turnStart(direction, angle);
+    if (!hold) {return;}
     
-    // buggy will rotate in 45 degree increments to account for 45, 90, 135 and 180 deg turns
-    for (unsigned char i = 0; i < angle/45; i++) {
-        increasePower(100);  // high power has more accuracy
-        __delay_ms(75);
-        stop();
-        __delay_ms(250);     // delay between multiple 45 deg turns
+    waitMotors();
+    waitUntil(getTicks() + hold);
+    stop();
+}
+
+/************************************************
+ *  Function to set the turn table to the uncalibrated defaults
+ *  Approximates the original sequence of 75ms 45 deg turns
+ ***********************************************/
+void turnsDefault(void) {
+    for (unsigned char d = 0; d < 2; d++) {
+        turns.hold[d][0] = 75;
+        turns.hold[d][1] = 165;
+        turns.hold[d][2] = 255;
+        turns.hold[d][3] = 345;
+    }
+}
+
+/************************************************
+ *  Function to load the turn table from EEPROM, or the defaults if it was never calibrated
+ ***********************************************/
+void turnsLoad(void) {
+    if (!eepromLoad(TURN_EEPROM, TURN_VERSION, (unsigned char *)&turns, sizeof(TURN_TABLE))) {
+        turnsDefault();
     }
 }
 
 /************************************************
- *  Function to increase the motor power to the required level
+ *  Function to store the turn table in EEPROM
  ***********************************************/
-void increasePower(unsigned char power) {
-    while (motorL.power < power || motorR.power < power) {
-        // increase both motorL and motorR power to desired power
-        if (motorL.power < power) { motorL.power++; }
-        if (motorR.power < power) { motorR.power++; }
+void turnsSave(void) {
+    eepromSave(TURN_EEPROM, TURN_VERSION, (unsigned char *)&turns, sizeof(TURN_TABLE));
+}
 
-        // set motor PWM to account for power change
-        setMotorPWM(&motorL);
-        setMotorPWM(&motorR);
-        __delay_us(100);
+/************************************************
+ *  Function to set the motor trim to unity gain and no offset
+ ***********************************************/
+void trimDefault(void) {
+    for (unsigned char i = 0; i < 2; i++) {
+        trim.gain[i] = 256;
+        trim.offset[i] = 0;
     }
 }
 
 /************************************************
- *  Function to move the buggy in a straight line a stop before hitting a wall
+ *  Function to rebuild both motor duty tables from the trim
  ***********************************************/
-void move2wall(DATA *data) {
-    // complete calibration of ambient light
-    BRAKE_LED = 1;
-    LED_on();
-    __delay_ms(500);
-    storeAmbient(data);
-    __delay_ms(500);
-    BRAKE_LED = 0;
+void trimApply(void) {
+    motorTable(&motorL, trim.gain[0], trim.offset[0]);
+    motorTable(&motorR, trim.gain[1], trim.offset[1]);
+}
+
+/************************************************
+ *  Function to load the motor trim from EEPROM, or the defaults if it was never calibrated
+ ***********************************************/
+void trimLoad(void) {
+    if (!eepromLoad(TRIM_EEPROM, TRIM_VERSION, (unsigned char *)&trim, sizeof(MOTOR_TRIM))) {
+        trimDefault();
+    }
+    trimApply();
+}
+
+/************************************************
+ *  Function to store the motor trim in EEPROM
+ ***********************************************/
+void trimSave(void) {
+    eepromSave(TRIM_EEPROM, TRIM_VERSION, (unsigned char *)&trim, sizeof(MOTOR_TRIM));
+}
+
+/************************************************
+ *  Function to wait up to 3s for a calibration adjustment
+ *  1: RF2 pressed, turn was too short
+ *  2: RF3 pressed, turn was too long
+ *  0: no press, accept the turn
+ ***********************************************/
+unsigned char turnAdjust(void) {
+    unsigned long deadline = getTicks() + 3000;
+    while (!deadlineReached(deadline)) {
+        if (!BUTTON_RF2 || !BUTTON_RF3) {
+            unsigned char result = !BUTTON_RF2 ? 1 : 2;
+            while (!BUTTON_RF2 || !BUTTON_RF3) {}  // wait for release
+            return result;
+        }
+    }
+    return 0;
+}
+
+/************************************************
+ *  Function to give more power to one motor, relative to the other
+ *  The gains are only ever reduced from unity, so full power stays reachable
+ *  by the slower motor; the offsets are only raised on the slower side
+ ***********************************************/
+static void trimBalance(unsigned char pass, unsigned char slow) {
+    unsigned char fast = !slow;
     
-    // reset timer and start moving forward whilst searching for a wall
-    resetTimer();               
-    while (1) {
-        straight(1, 20);
-        storeColor(data);
+    if (pass == 0) {
+        if (trim.gain[slow] < 256) {trim.gain[slow] += TRIM_GAIN_STEP;}
+        else if (trim.gain[fast] > 128) {trim.gain[fast] -= TRIM_GAIN_STEP;}
+    } else {
+        if (trim.offset[fast] >= TRIM_OFFSET_STEP) {trim.offset[fast] -= TRIM_OFFSET_STEP;}
+        else if (trim.offset[slow] < TRIM_OFFSET_MAX) {trim.offset[slow] += TRIM_OFFSET_STEP;}
+    }
+    trimApply();
+}
 
-        // stop the buggy if the clear channel exits the threshold
-        if (data->hsv.c < data->ambLight - 13 || data->hsv.c > data->ambLight + 30) {
+/************************************************
+ *  Function to calibrate the motor trim from the button menu
+ *  The buggy drives straight at TRIM_POWER to trim the gains, then at
+ *  APPROACH_MIN to trim the offsets; the brake lights stay on meanwhile.
+ *  After each run RF2 means it veered left, RF3 means it veered right and
+ *  no press for 3s accepts it; the trim is saved to EEPROM
+ ***********************************************/
+void calibrateTrim(void) {
+    while (!BUTTON_RF2 || !BUTTON_RF3) {}    // wait for the menu buttons to be released
+    BRAKE_LED = 1;
+    
+    for (unsigned char pass = 0; pass < 2; pass++) {
+        LED_flash(pass + 1);                 // flash indicators to show which power is trimmed
+        while (BUTTON_RF2) {}                // wait for button press to start
+        
+        unsigned char adjust = 1;
+        while (adjust) {
+            __delay_ms(500);
+            straight(1, pass ? APPROACH_MIN : TRIM_POWER);
+            waitUntil(getTicks() + TRIM_TIME);
             stop();
             
-            // do not store the movement if the color was not previously detected
-            if (data->count == 0) {
-                addMove(data, 0, 1, 20, get16bitTMR0val() + 400);   // add movement towards the wall in the forward sequence
-            };
+            adjust = turnAdjust();
+            if (adjust) {trimBalance(pass, adjust == 1 ? 0 : 1);}  // veered left: the left motor is slow
+        }
+    }
+    
+    BRAKE_LED = 0;
+    trimSave();
+}
+
+/************************************************
+ *  Function to calibrate the turn table from the button menu
+ *  For each direction and angle the buggy turns, then RF2 lengthens the turn,
+ *  RF3 shortens it and no press for 3s accepts it; the table is saved to EEPROM.
+ *  Hold times stay between TURN_TRIM and TURN_HOLD_MAX
+ ***********************************************/
+void calibrateTurns(void) {
+    while (!BUTTON_RF2 || !BUTTON_RF3) {}    // wait for the menu buttons to be released
+    
+    for (unsigned char d = 0; d < 2; d++) {
+        for (unsigned char a = 0; a < 4; a++) {
+            LED_flash(d*4 + a + 1);          // flash indicators to show which turn to calibrate
+            while (BUTTON_RF2) {}            // wait for button press to start
             
-            break;
-        }  
+            unsigned char adjust = 1;
+            while (adjust) {
+                __delay_ms(500);
+                rotate(d, (a + 1)*45);
+                
+                adjust = turnAdjust();
+                if (adjust == 1 && turns.hold[d][a] <= TURN_HOLD_MAX - TURN_TRIM) {
+                    turns.hold[d][a] += TURN_TRIM;
+                } else if (adjust == 2 && turns.hold[d][a] > TURN_TRIM) {
+                    turns.hold[d][a] -= TURN_TRIM;
+                }
+            }
+        }
     }
+    
+    turnsSave();
 }
 
 /************************************************
- *  Function to initialise the colour click module using I2C
+ *  Function to choose the approach power from the clear channel
+ *  Slows down in proportion to how close the clear channel is to the wall threshold,
+ *  and how few samples it will take to get there at the current gradient (change per sample)
  ***********************************************/
-void colorAction(DATA *data) {
-    // drive into the wall to align buggy
-    straight(1, 40);
-    __delay_ms(500);
-    stop();
+unsigned char approachPower(unsigned int c, int slope, unsigned int ambLight, unsigned int lower, unsigned int upper) {
+    unsigned int threshold, remaining, rate;
     
-    // store the color of the wall
-    __delay_ms(500);
-    char decision = detectColor(data);
-    __delay_ms(500);
+    // distance left to the threshold on the side the clear channel is moving towards
+    if (c < ambLight) {
+        threshold = lower;
+        remaining = ambLight - c < lower ? lower - (ambLight - c) : 0;
+    } else {
+        threshold = upper;
+        remaining = c - ambLight < upper ? upper - (c - ambLight) : 0;
+    }
     
-    // move backwards away from the wall
-    straight(0, 20);
-    __delay_ms(700);
-    stop();
+    // change per sample towards the threshold (zero if moving back to ambient)
+    if (c < ambLight) {
+        rate = slope < 0 ? -slope : 0;
+    } else {
+        rate = slope > 0 ? slope : 0;
+    }
     
-    // do not store the movement if the color was not previously detected
-    if (data->count == 0) {addMove(data, 0, 0, 40, 600);}
-    __delay_ms(1000);
+    // scale by remaining fraction of the threshold
+    unsigned int scale = (unsigned long)remaining * 256 / threshold;
     
-    // complete action based on color of wall and addMove according to action taken
-    switch (decision) {
-        case 0:  // red -> turn right 90 deg
-            rotate(1, 90);
-            addMove(data, 1, 1, 90, 0);
-            break;
-            
-        case 1:  // green -> turn left 90 deg
-            rotate(0, 90);
-            addMove(data, 1, 0, 90, 0);
-            break;
-            
-        case 2:  // blue -> turn 180 deg
-            rotate(0, 180);
-            addMove(data, 1, 0, 180, 0);
-            break;
-            
-        case 3:  // yellow -> reverse 1 square and turn right 90 deg
-            straight(0, 20);
-            __delay_ms(2500);
-            stop();
-            addMove(data, 0, 0, 20, 2500);
-            __delay_ms(500);
-            rotate(1, 90);
-            addMove(data, 1, 1, 90, 0);
-            break;
-            
-        case 4:  // pink -> reverse 1 square and turn left 90 deg
-            straight(0, 20);
-            __delay_ms(2500);
-            stop();
-            addMove(data, 0, 0, 20, 2500);
-            __delay_ms(500);
-            rotate(0, 90);
-            addMove(data, 1, 0, 90, 0);
-            break;
-            
-        case 5:  // orange -> turn right 135 deg
-            rotate(1, 135);
-            addMove(data, 1, 1, 135, 0);
-            break;
-            
-        case 6:  // light blue -> turn left 135 deg
-            rotate(0, 135);
-            addMove(data, 1, 0, 135, 0);
-            break;
-        
-        case 7:  // white -> finish, 'trigger return to home'
-            data->backtrack = 1;        // update backtrack flag to return to starting position
-            break;
-            
-        case 8:  // no color found (black)
-            data->count++;
-            if (data->count >= 3) {     // check if the wall has been detected to be black 3 times
-                data->backtrack = 1;    // update backtrack flag to return to starting position
-            }
-            break;
+    // scale by number of samples left at the current gradient
+    if (rate && remaining < (unsigned long)rate * APPROACH_HORIZON) {
+        unsigned int horizon = (unsigned long)remaining * 256 / ((unsigned long)rate * APPROACH_HORIZON);
+        if (horizon < scale) {scale = horizon;}
     }
     
-    // reset the counter if a color was found
-    if (decision != 8) {data->count = 0;}
-}
\ No newline at end of file
+    return APPROACH_MIN + (unsigned char)(((unsigned int)(APPROACH_MAX - APPROACH_MIN) * scale) >> 8);
+}
@@ -1,22 +1,57 @@
 #ifndef _dc_motor_H
 #define _dc_motor_H
 
-#include <xc.h>
+#include "hal.h"
 #include "color.h"
 #include "sequence.h"
 #include "structures.h"
 
 #define _XTAL_FREQ 64000000 // note intrinsic _delay function is 62.5ns at 64,000,000Hz  
+#define APPROACH_MAX 50     // cruise power while the clear channel is near ambient
+#define APPROACH_MIN 20     // crawl power as the wall threshold is reached
+#define APPROACH_HORIZON 8  // samples to threshold below which the buggy starts slowing down
+#define PWM_FREQ 10000      // motor PWM frequency (Hz)
+#define TURN_POWER 100      // power used for rotations (high power has more accuracy)
+#define TURN_TRIM 10        // hold time adjustment (ms) per calibration button press
+#define TURN_HOLD_MAX 1000  // longest hold time (ms) calibration can set, a 180 deg turn needs about 345
+#define TURN_EEPROM 0x000   // EEPROM address of the turn table record
+#define TURN_VERSION 1      // turn table record version, change when TURN_TABLE changes
+#define TRIM_EEPROM 0x020   // EEPROM address of the motor trim record
+#define TRIM_VERSION 1      // motor trim record version, change when MOTOR_TRIM changes
+#define TRIM_POWER 50       // power of the straight run used to trim the gains
+#define TRIM_TIME 2000      // length (ms) of each straight trim run
+#define TRIM_GAIN_STEP 4    // gain adjustment (1/256) per calibration button press
+#define TRIM_OFFSET_STEP 1  // offset adjustment (power) per calibration button press
+#define TRIM_OFFSET_MAX 30  // largest deadband offset
 
-DC_MOTOR motorL, motorR;    // declare two DC_motor structures
+extern DC_MOTOR motorL, motorR;    // left and right DC_motor structures
+extern TURN_TABLE turns;           // calibrated turn table
+extern MOTOR_TRIM trim;            // calibrated motor trim
 
-void initDCmotorsPWM(unsigned char PWMperiod);
+void initDCmotorsPWM(unsigned int frequency);
+void motorTable(DC_MOTOR *m, unsigned int gain, unsigned char offset);
 void setMotorPWM(DC_MOTOR *m);
+unsigned int motorPower(DC_MOTOR *m);
+void setMotorTarget(DC_MOTOR *m, unsigned char direction, unsigned char power);
+void motorStep(DC_MOTOR *m);
+void motorTask(void);
+unsigned char motorsSettled(void);
+void waitMotors(void);
+void motorsStop(void);
 void stop(void);
 void straight(unsigned char direction, unsigned char power);
+unsigned int turnStart(unsigned char direction, unsigned char angle);
 void rotate(unsigned char direction, unsigned char angle);
-void increasePower(unsigned char power);
-void move2wall(DATA *data);
-void colorAction(DATA *data);
+void turnsDefault(void);
+void turnsLoad(void);
+void turnsSave(void);
+unsigned char turnAdjust(void);
+void trimDefault(void);
+void trimApply(void);
+void trimLoad(void);
+void trimSave(void);
+void calibrateTrim(void);
+void calibrateTurns(void);
+unsigned char approachPower(unsigned int c, int slope, unsigned int ambLight, unsigned int lower, unsigned int upper);
 
 #endif
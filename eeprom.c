@@ -0,0 +1,107 @@
+#include "hal.h"
+#include "eeprom.h"
+
+/************************************************
+ *  Function to read a byte from the data EEPROM
+ ***********************************************/
+unsigned char eepromRead(unsigned int address) {
+    NVMADRL = address & 0xFF;       // EEPROM address low byte
+    NVMADRH = address >> 8;         // EEPROM address high byte
+    NVMCON1bits.NVMREG = 0b00;      // access data EEPROM
+    NVMCON1bits.RD = 1;             // initiate read
+    return NVMDAT;
+}
+
+/************************************************
+ *  Function to write a byte to the data EEPROM
+ *  Skips the write if the byte is unchanged to save endurance
+ ***********************************************/
+void eepromWrite(unsigned int address, unsigned char value) {
+    if (eepromRead(address) == value) {return;}
+
+    NVMADRL = address & 0xFF;       // EEPROM address low byte
+    NVMADRH = address >> 8;         // EEPROM address high byte
+    NVMDAT = value;                 // data to write
+    NVMCON1bits.NVMREG = 0b00;      // access data EEPROM
+    NVMCON1bits.WREN = 1;           // enable writes
+
+    unsigned char gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;             // unlock sequence must not be interrupted
+    NVMCON2 = 0x55;
+    NVMCON2 = 0xAA;
+    NVMCON1bits.WR = 1;             // initiate write
+    INTCONbits.GIE = gie;
+
+    while (NVMCON1bits.WR) {}       // wait for the write to complete
+    NVMCON1bits.WREN = 0;           // disable writes
+}
+
+/************************************************
+ *  Function to read a block of bytes from the data EEPROM
+ ***********************************************/
+void eepromReadBlock(unsigned int address, unsigned char *data, unsigned int length) {
+    for (unsigned int i = 0; i < length; i++) {
+        data[i] = eepromRead(address + i);
+    }
+}
+
+/************************************************
+ *  Function to write a block of bytes to the data EEPROM
+ ***********************************************/
+void eepromWriteBlock(unsigned int address, unsigned char *data, unsigned int length) {
+    for (unsigned int i = 0; i < length; i++) {
+        eepromWrite(address + i, data[i]);
+    }
+}
+
+/************************************************
+ *  Function to update a CRC-16-CCITT (polynomial 0x1021) with a block of bytes
+ ***********************************************/
+unsigned int eepromCRC(unsigned int crc, unsigned char *data, unsigned int length) {
+    for (unsigned int i = 0; i < length; i++) {
+        crc ^= (unsigned int)data[i] << 8;
+        for (unsigned char b = 0; b < 8; b++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc & 0xFFFF;    // no-op on the target, int is wider on the host build
+}
+
+/************************************************
+ *  Function to store a versioned, CRC protected record
+ *  Layout: version, length, data..., CRC low, CRC high
+ *  The version byte is written last so an interrupted save is never loaded
+ ***********************************************/
+void eepromSave(unsigned int address, unsigned char version, unsigned char *data, unsigned char length) {
+    unsigned int crc = eepromCRC(0xFFFF, &version, 1);
+    crc = eepromCRC(crc, &length, 1);
+    crc = eepromCRC(crc, data, length);
+
+    eepromWrite(address, 0xFF);                     // invalidate the record while it is written
+    eepromWrite(address + 1, length);
+    eepromWriteBlock(address + 2, data, length);
+    eepromWrite(address + 2 + length, crc & 0xFF);
+    eepromWrite(address + 3 + length, crc >> 8);
+    eepromWrite(address, version);                  // validate the record
+}
+
+/************************************************
+ *  Function to load a versioned, CRC protected record
+ *  1: record loaded into 'data'
+ *  0: no valid record of this version and length, 'data' is unchanged
+ ***********************************************/
+unsigned char eepromLoad(unsigned int address, unsigned char version, unsigned char *data, unsigned char length) {
+    if (eepromRead(address) != version || eepromRead(address + 1) != length) {return 0;}
+
+    unsigned int crc = eepromCRC(0xFFFF, &version, 1);
+    crc = eepromCRC(crc, &length, 1);
+    for (unsigned char i = 0; i < length; i++) {
+        unsigned char byte = eepromRead(address + 2 + i);
+        crc = eepromCRC(crc, &byte, 1);
+    }
+    unsigned int stored = eepromRead(address + 2 + length) | (unsigned int)eepromRead(address + 3 + length) << 8;
+    if (crc != stored) {return 0;}
+
+    eepromReadBlock(address + 2, data, length);
+    return 1;
+}
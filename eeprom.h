@@ -0,0 +1,17 @@
+#ifndef _eeprom_H
+#define _eeprom_H
+
+#include "hal.h"
+
+#define _XTAL_FREQ 64000000
+#define EEPROM_RECORD 4     // bytes added to each record (version, length and CRC)
+
+unsigned char eepromRead(unsigned int address);
+void eepromWrite(unsigned int address, unsigned char value);
+void eepromReadBlock(unsigned int address, unsigned char *data, unsigned int length);
+void eepromWriteBlock(unsigned int address, unsigned char *data, unsigned int length);
+unsigned int eepromCRC(unsigned int crc, unsigned char *data, unsigned int length);
+void eepromSave(unsigned int address, unsigned char version, unsigned char *data, unsigned char length);
+unsigned char eepromLoad(unsigned int address, unsigned char version, unsigned char *data, unsigned char length);
+
+#endif
@@ -0,0 +1,100 @@
+#include "hal.h"
+#include "filter.h"
+#include "structures.h"
+
+/************************************************
+ *  Function to empty the filter, used when the sensor settings change
+ ***********************************************/
+void filterReset(FILTER *f) {
+    f->head = 0;
+    f->count = 0;
+    for (unsigned char k = 0; k < 4; k++) {f->sum[k] = 0;}
+}
+
+/************************************************
+ *  Function to add a sample to the filter ring
+ *  The moving average sums are updated by adding the new sample and
+ *  removing the one leaving the window, so each sample costs O(1)
+ ***********************************************/
+void filterAdd(FILTER *f, RGB rgb, unsigned long time) {
+    // remove the sample leaving the moving average window
+    if (f->count >= FILTER_WINDOW) {
+        RGB *old = &f->ring[(f->head - FILTER_WINDOW) & (FILTER_SIZE - 1)].rgb;
+        f->sum[0] -= old->r;
+        f->sum[1] -= old->g;
+        f->sum[2] -= old->b;
+        f->sum[3] -= old->c;
+    }
+    
+    SAMPLE *s = &f->ring[f->head];
+    s->rgb = rgb;
+    s->time = time;
+    f->sum[0] += rgb.r;
+    f->sum[1] += rgb.g;
+    f->sum[2] += rgb.b;
+    f->sum[3] += rgb.c;
+    
+    if (f->count < FILTER_SIZE) {f->count++;}
+    f->head = (f->head + 1) & (FILTER_SIZE - 1);
+    s->meanC = filterMean(f).c;     // kept for the derivative
+}
+
+/************************************************
+ *  Function to return a sample from the ring, age 0 is the newest
+ *  Returns 0 if the filter does not hold that many samples
+ ***********************************************/
+SAMPLE *filterSample(FILTER *f, unsigned char age) {
+    if (age >= f->count) {return 0;}
+    return &f->ring[(f->head - 1 - age) & (FILTER_SIZE - 1)];
+}
+
+/************************************************
+ *  Function to return the moving average of the last FILTER_WINDOW samples
+ ***********************************************/
+RGB filterMean(FILTER *f) {
+    RGB mean = {0, 0, 0, 0};
+    unsigned char n = f->count < FILTER_WINDOW ? f->count : FILTER_WINDOW;
+    if (n == 0) {return mean;}
+    
+    mean.r = f->sum[0] / n;
+    mean.g = f->sum[1] / n;
+    mean.b = f->sum[2] / n;
+    mean.c = f->sum[3] / n;
+    return mean;
+}
+
+/************************************************
+ *  Function to return the median of three values
+ ***********************************************/
+static unsigned int median3(unsigned int a, unsigned int b, unsigned int c) {
+    if (a > b) {unsigned int t = a; a = b; b = t;}  // order a <= b
+    return c < a ? a : (c > b ? b : c);
+}
+
+/************************************************
+ *  Function to return the median of the last three samples of each channel
+ *  A single spike is rejected, with fewer samples the mean is returned
+ ***********************************************/
+RGB filterMedian(FILTER *f) {
+    if (f->count < 3) {return filterMean(f);}
+    
+    RGB *a = &filterSample(f, 0)->rgb;
+    RGB *b = &filterSample(f, 1)->rgb;
+    RGB *c = &filterSample(f, 2)->rgb;
+    RGB median;
+    median.r = median3(a->r, b->r, c->r);
+    median.g = median3(a->g, b->g, c->g);
+    median.b = median3(a->b, b->b, c->b);
+    median.c = median3(a->c, b->c, c->c);
+    return median;
+}
+
+/************************************************
+ *  Function to return the change of the averaged clear channel over the last sample
+ *  The first difference of a moving average is (c[n] - c[n-WINDOW]) / WINDOW,
+ *  a derivative that one noisy reading can only move by 1/WINDOW
+ ***********************************************/
+int filterSlope(FILTER *f) {
+    if (f->count < 2) {return 0;}
+    return (int)(filterSample(f, 0)->meanC - filterSample(f, 1)->meanC);
+}
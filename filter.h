@@ -0,0 +1,16 @@
+#ifndef _filter_H
+#define _filter_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+void filterReset(FILTER *f);
+void filterAdd(FILTER *f, RGB rgb, unsigned long time);
+SAMPLE *filterSample(FILTER *f, unsigned char age);
+RGB filterMean(FILTER *f);
+RGB filterMedian(FILTER *f);
+int filterSlope(FILTER *f);
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _hal_H
+#define _hal_H
+
+/************************************************
+ *  Hardware abstraction for the PIC18F67K40 peripherals used by the buggy
+ *  Target builds use the XC8 device header directly. Host builds (HOST_SIM)
+ *  get the same register names as plain variables, backed by hal_sim.c,
+ *  so the firmware can be compiled and linked against a simulated buggy
+ ***********************************************/
+
+#ifndef HOST_SIM
+
+#include <xc.h>
+
+#else
+
+// declare an 8 bit register with named bit fields (LSB first) aliased to the whole byte
+#define HAL_SFR_TYPE(name, ...) \
+    typedef union { struct { __VA_ARGS__ }; unsigned char val; } name##bits_t;
+#define HAL_SFR(name, ...) HAL_SFR_TYPE(name, __VA_ARGS__) \
+    extern volatile name##bits_t name##bits;
+
+#define HAL_PORT(p) HAL_SFR(p, unsigned p##0:1; unsigned p##1:1; unsigned p##2:1; unsigned p##3:1; \
+                               unsigned p##4:1; unsigned p##5:1; unsigned p##6:1; unsigned p##7:1;)
+
+// digital I/O (LAT, TRIS, ANSEL and PORT registers)
+HAL_PORT(LATA) HAL_PORT(LATC) HAL_PORT(LATD) HAL_PORT(LATE) HAL_PORT(LATF) HAL_PORT(LATG) HAL_PORT(LATH)
+HAL_PORT(TRISA) HAL_PORT(TRISC) HAL_PORT(TRISD) HAL_PORT(TRISE) HAL_PORT(TRISF) HAL_PORT(TRISG) HAL_PORT(TRISH)
+HAL_PORT(ANSELD) HAL_PORT(ANSELF)
+HAL_SFR(PORTF, unsigned RF0:1; unsigned RF1:1; unsigned RF2:1; unsigned RF3:1;
+               unsigned RF4:1; unsigned RF5:1; unsigned RF6:1; unsigned RF7:1;)
+
+// interrupt control
+HAL_SFR(INTCON, unsigned INT0EDG:1; unsigned INT1EDG:1; unsigned INT2EDG:1; unsigned INT3EDG:1;
+                unsigned :1; unsigned IPEN:1; unsigned PEIE:1; unsigned GIE:1;)
+HAL_SFR(PIE0, unsigned INT0IE:1; unsigned INT1IE:1; unsigned INT2IE:1; unsigned INT3IE:1;
+              unsigned IOCIE:1; unsigned TMR0IE:1; unsigned :2;)
+HAL_SFR(PIR0, unsigned INT0IF:1; unsigned INT1IF:1; unsigned INT2IF:1; unsigned INT3IF:1;
+              unsigned IOCIF:1; unsigned TMR0IF:1; unsigned :2;)
+HAL_SFR(PIE3, unsigned SSP1IE:1; unsigned BCL1IE:1; unsigned SSP2IE:1; unsigned BCL2IE:1;
+              unsigned TX1IE:1; unsigned RC1IE:1; unsigned TX2IE:1; unsigned RC2IE:1;)
+HAL_SFR(PIR3, unsigned SSP1IF:1; unsigned BCL1IF:1; unsigned SSP2IF:1; unsigned BCL2IF:1;
+              unsigned TX1IF:1; unsigned RC1IF:1; unsigned TX2IF:1; unsigned RC2IF:1;)
+HAL_SFR(PIE5, unsigned TMR1IE:1; unsigned TMR2IE:1; unsigned TMR3IE:1; unsigned TMR4IE:1;
+              unsigned TMR5IE:1; unsigned TMR6IE:1; unsigned TMR7IE:1; unsigned TMR8IE:1;)
+HAL_SFR(PIR5, unsigned TMR1IF:1; unsigned TMR2IF:1; unsigned TMR3IF:1; unsigned TMR4IF:1;
+              unsigned TMR5IF:1; unsigned TMR6IF:1; unsigned TMR7IF:1; unsigned TMR8IF:1;)
+HAL_SFR(PIE4, unsigned TX3IE:1; unsigned RC3IE:1; unsigned TX4IE:1; unsigned RC4IE:1;
+              unsigned TX5IE:1; unsigned RC5IE:1; unsigned :2;)
+HAL_SFR(PIR4, unsigned TX3IF:1; unsigned RC3IF:1; unsigned TX4IF:1; unsigned RC4IF:1;
+              unsigned TX5IF:1; unsigned RC5IF:1; unsigned :2;)
+
+// timer 0 (heartbeat), timer 1 (profiling), timer 2 (PWM timebase) and timer 4 (control tick)
+HAL_SFR(T0CON0, unsigned T0OUTPS:4; unsigned T016BIT:1; unsigned T0OUT:1; unsigned :1; unsigned T0EN:1;)
+HAL_SFR(T0CON1, unsigned T0CKPS:4; unsigned T0ASYNC:1; unsigned T0CS:3;)
+HAL_SFR(T1CON, unsigned ON:1; unsigned RD16:1; unsigned nSYNC:1; unsigned :1; unsigned CKPS:2; unsigned :2;)
+HAL_SFR(T1CLK, unsigned CS:4; unsigned :4;)
+HAL_SFR(T2CON, unsigned OUTPS:4; unsigned CKPS:3; unsigned ON:1;)
+HAL_SFR(T2HLT, unsigned MODE:5; unsigned CKSYNC:1; unsigned CKPOL:1; unsigned PSYNC:1;)
+HAL_SFR(T2CLKCON, unsigned CS:4; unsigned :4;)
+HAL_SFR(T4CON, unsigned OUTPS:4; unsigned CKPS:3; unsigned ON:1;)
+HAL_SFR(T4HLT, unsigned MODE:5; unsigned CKSYNC:1; unsigned CKPOL:1; unsigned PSYNC:1;)
+HAL_SFR(T4CLKCON, unsigned CS:4; unsigned :4;)
+extern volatile unsigned char TMR0L, TMR0H, TMR1L, TMR1H, T2PR, T4PR;
+
+// CCP modules in PWM mode (motor outputs)
+HAL_SFR(CCP1CON, unsigned CCP1MODE:4; unsigned FMT:1; unsigned OUT:1; unsigned :1; unsigned EN:1;)
+HAL_SFR(CCP2CON, unsigned CCP2MODE:4; unsigned FMT:1; unsigned OUT:1; unsigned :1; unsigned EN:1;)
+HAL_SFR(CCP3CON, unsigned CCP3MODE:4; unsigned FMT:1; unsigned OUT:1; unsigned :1; unsigned EN:1;)
+HAL_SFR(CCP4CON, unsigned CCP4MODE:4; unsigned FMT:1; unsigned OUT:1; unsigned :1; unsigned EN:1;)
+HAL_SFR(CCPTMRS0, unsigned C1TSEL:2; unsigned C2TSEL:2; unsigned C3TSEL:2; unsigned C4TSEL:2;)
+extern volatile unsigned char CCPR1L, CCPR1H, CCPR2L, CCPR2H, CCPR3L, CCPR3H, CCPR4L, CCPR4H;
+
+// MSSP2 in I2C master mode (colour click)
+HAL_SFR(SSP2STAT, unsigned BF:1; unsigned UA:1; unsigned R_nW:1; unsigned S:1;
+                  unsigned P:1; unsigned D_nA:1; unsigned CKE:1; unsigned SMP:1;)
+HAL_SFR(SSP2CON1, unsigned SSPM:4; unsigned CKP:1; unsigned SSPEN:1; unsigned SSPOV:1; unsigned WCOL:1;)
+HAL_SFR(SSP2CON2, unsigned SEN:1; unsigned RSEN:1; unsigned PEN:1; unsigned RCEN:1;
+                  unsigned ACKEN:1; unsigned ACKDT:1; unsigned ACKSTAT:1; unsigned GCEN:1;)
+extern volatile unsigned char SSP2BUF, SSP2ADD;
+
+// EUSART4 (serial)
+HAL_SFR(BAUD4CON, unsigned ABDEN:1; unsigned WUE:1; unsigned :1; unsigned BRG16:1;
+                  unsigned SCKP:1; unsigned :1; unsigned RCIDL:1; unsigned ABDOVF:1;)
+HAL_SFR(TX4STA, unsigned TX9D:1; unsigned TRMT:1; unsigned BRGH:1; unsigned SENDB:1;
+                unsigned SYNC:1; unsigned TXEN:1; unsigned TX9:1; unsigned CSRC:1;)
+HAL_SFR(RC4STA, unsigned RX9D:1; unsigned OERR:1; unsigned FERR:1; unsigned ADDEN:1;
+                unsigned CREN:1; unsigned SREN:1; unsigned RX9:1; unsigned SPEN:1;)
+// TX4REG is reached through an accessor, so the host model sees every byte loaded
+volatile unsigned char *hal_sim_tx4reg(void);
+#define TX4REG (*hal_sim_tx4reg())
+extern unsigned char hal_sim_tx_loaded;
+extern volatile unsigned char RC4REG, SP4BRGL, SP4BRGH;
+
+// non-volatile memory controller (data EEPROM)
+// NVMCON1 and NVMDAT are reached through accessors, so a read or write started
+// with RD or WR completes the next time the firmware touches the controller
+HAL_SFR_TYPE(NVMCON1, unsigned RD:1; unsigned WR:1; unsigned WREN:1; unsigned WRERR:1;
+                      unsigned FREE:1; unsigned :1; unsigned NVMREG:2;)
+volatile NVMCON1bits_t *hal_sim_nvmcon1(void);
+volatile unsigned char *hal_sim_nvmdat(void);
+#define NVMCON1bits (*hal_sim_nvmcon1())
+#define NVMDAT (*hal_sim_nvmdat())
+#define HAL_EEPROM_SIZE 1024
+extern unsigned char hal_sim_eeprom[HAL_EEPROM_SIZE];
+extern volatile unsigned char NVMCON2, NVMADRL, NVMADRH;
+
+// peripheral pin select
+extern volatile unsigned char RC0PPS, RC7PPS, RD5PPS, RD6PPS, RE2PPS, RE4PPS, RG6PPS;
+extern volatile unsigned char RX4PPS, SSP2DATPPS, SSP2CLKPPS;
+
+// whole register access aliased onto the bit field unions
+#define SSP2STAT SSP2STATbits.val
+#define SSP2CON2 SSP2CON2bits.val
+
+// compiler intrinsics, the delays hand simulated time to the host model
+#define __interrupt(priority)
+void __delay_ms(unsigned long ms);
+void __delay_us(unsigned long us);
+extern void (*hal_sim_delay)(unsigned long us);
+
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#ifdef HOST_SIM
+
+#include "hal.h"
+
+/************************************************
+ *  Host register model for the simulated buggy
+ *  Every register used by the firmware is a plain variable that the
+ *  simulator reads and writes between calls into the firmware
+ ***********************************************/
+volatile LATAbits_t LATAbits;
+volatile LATCbits_t LATCbits;
+volatile LATDbits_t LATDbits;
+volatile LATEbits_t LATEbits;
+volatile LATFbits_t LATFbits;
+volatile LATGbits_t LATGbits;
+volatile LATHbits_t LATHbits;
+volatile TRISAbits_t TRISAbits;
+volatile TRISCbits_t TRISCbits;
+volatile TRISDbits_t TRISDbits;
+volatile TRISEbits_t TRISEbits;
+volatile TRISFbits_t TRISFbits;
+volatile TRISGbits_t TRISGbits;
+volatile TRISHbits_t TRISHbits;
+volatile ANSELDbits_t ANSELDbits;
+volatile ANSELFbits_t ANSELFbits;
+volatile PORTFbits_t PORTFbits;
+volatile INTCONbits_t INTCONbits;
+volatile PIE0bits_t PIE0bits;
+volatile PIR0bits_t PIR0bits;
+volatile PIE3bits_t PIE3bits;
+volatile PIR3bits_t PIR3bits;
+volatile PIE4bits_t PIE4bits;
+volatile PIR4bits_t PIR4bits;
+volatile PIE5bits_t PIE5bits;
+volatile PIR5bits_t PIR5bits;
+volatile T0CON0bits_t T0CON0bits;
+volatile T0CON1bits_t T0CON1bits;
+volatile T1CONbits_t T1CONbits;
+volatile T1CLKbits_t T1CLKbits;
+volatile T2CONbits_t T2CONbits;
+volatile T2HLTbits_t T2HLTbits;
+volatile T2CLKCONbits_t T2CLKCONbits;
+volatile T4CONbits_t T4CONbits;
+volatile T4HLTbits_t T4HLTbits;
+volatile T4CLKCONbits_t T4CLKCONbits;
+volatile CCP1CONbits_t CCP1CONbits;
+volatile CCP2CONbits_t CCP2CONbits;
+volatile CCP3CONbits_t CCP3CONbits;
+volatile CCP4CONbits_t CCP4CONbits;
+volatile CCPTMRS0bits_t CCPTMRS0bits;
+volatile SSP2STATbits_t SSP2STATbits;
+volatile SSP2CON1bits_t SSP2CON1bits;
+volatile SSP2CON2bits_t SSP2CON2bits;
+volatile BAUD4CONbits_t BAUD4CONbits;
+volatile TX4STAbits_t TX4STAbits;
+volatile RC4STAbits_t RC4STAbits;
+
+volatile unsigned char TMR0L, TMR0H, TMR1L, TMR1H, T2PR, T4PR, CCPR1L, CCPR1H, CCPR2L, CCPR2H, CCPR3L, CCPR3H, CCPR4L,
+    CCPR4H, SSP2BUF, SSP2ADD, RC4REG, SP4BRGL, SP4BRGH, RC0PPS, RC7PPS, RD5PPS, RD6PPS,
+    RE2PPS, RE4PPS, RG6PPS, RX4PPS, SSP2DATPPS, SSP2CLKPPS, NVMCON2, NVMADRL, NVMADRH;
+
+void (*hal_sim_delay)(unsigned long us) = 0;  // simulator hook advanced by every busy wait
+
+unsigned char hal_sim_eeprom[HAL_EEPROM_SIZE];  // data EEPROM contents, filled by the simulator
+static volatile NVMCON1bits_t nvmcon1;
+static volatile unsigned char nvmdat;
+
+/************************************************
+ *  Function to access NVMCON1, a write started by setting WR is committed
+ *  to the EEPROM the next time the register is touched
+ ***********************************************/
+volatile NVMCON1bits_t *hal_sim_nvmcon1(void) {
+    unsigned int address = ((unsigned int)NVMADRH << 8 | NVMADRL) % HAL_EEPROM_SIZE;
+    if (nvmcon1.WR) {
+        if (nvmcon1.WREN) {hal_sim_eeprom[address] = nvmdat;}
+        nvmcon1.WR = 0;
+    }
+    return &nvmcon1;
+}
+
+/************************************************
+ *  Function to access NVMDAT, a read started by setting RD loads the
+ *  addressed EEPROM byte first
+ ***********************************************/
+volatile unsigned char *hal_sim_nvmdat(void) {
+    unsigned int address = ((unsigned int)NVMADRH << 8 | NVMADRL) % HAL_EEPROM_SIZE;
+    if (nvmcon1.RD) {
+        nvmdat = hal_sim_eeprom[address];
+        nvmcon1.RD = 0;
+    }
+    return &nvmdat;
+}
+
+unsigned char hal_sim_tx_loaded = 0;              // set when TX4REG is loaded, cleared by the simulator
+static volatile unsigned char tx4reg;
+
+/************************************************
+ *  Function to access TX4REG, the firmware only writes it so each access
+ *  marks a byte loaded for transmission
+ ***********************************************/
+volatile unsigned char *hal_sim_tx4reg(void) {
+    hal_sim_tx_loaded = 1;
+    return &tx4reg;
+}
+
+/************************************************
+ *  Function to replace the XC8 millisecond delay on the host
+ ***********************************************/
+void __delay_ms(unsigned long ms) {
+    if (hal_sim_delay) {hal_sim_delay(ms * 1000);}
+}
+
+/************************************************
+ *  Function to replace the XC8 microsecond delay on the host
+ ***********************************************/
+void __delay_us(unsigned long us) {
+    if (hal_sim_delay) {hal_sim_delay(us);}
+}
+
+#endif
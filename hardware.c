@@ -1,6 +1,12 @@
-#include <xc.h>
+#include "hal.h"
 #include "hardware.h"
 
+static unsigned char buttonState = 0;        // debounced buttons pressed, bit 0 RF2, bit 1 RF3
+static unsigned char buttonCount = 0;        // samples the raw buttons have differed from buttonState
+static unsigned char buttonSeen = 0;         // buttons pressed since all were last released (bit 7: ignore)
+static unsigned char buttonHeld = 0;         // samples both buttons have been held
+static unsigned char buttonPending = BUTTON_NONE;  // event waiting to be collected
+
 /************************************************
  *  Function to initialise all hardware bits
  ***********************************************/
@@ -72,3 +78,50 @@ void LED_flash(unsigned char num) {
     }
 }
 
+
+/************************************************
+ *  Function to debounce the buttons, run every BUTTON_PERIOD ms by the scheduler
+ *  An event is raised when all buttons are released, so pressing both
+ *  together is reported once as a combination rather than as two presses
+ ***********************************************/
+void buttonTask(void) {
+    unsigned char raw = (!BUTTON_RF2 ? 0x01 : 0) | (!BUTTON_RF3 ? 0x02 : 0);  // buttons are active low
+    
+    if (raw == buttonState) {
+        buttonCount = 0;
+    } else if (++buttonCount >= BUTTON_DEBOUNCE) {
+        buttonState = raw;
+        buttonCount = 0;
+    }
+    
+    buttonSeen |= buttonState;
+    if (buttonState == 0x03 && buttonHeld < BUTTON_HOLD) {buttonHeld++;}
+    
+    // all released, report what was pressed
+    if (buttonState == 0 && buttonSeen) {
+        if (!(buttonSeen & 0x80)) {
+            buttonPending = buttonHeld >= BUTTON_HOLD ? BUTTON_HOLD_BOTH : buttonSeen;
+        }
+        buttonSeen = 0;
+        buttonHeld = 0;
+    }
+}
+
+/************************************************
+ *  Function to collect the last button event
+ ***********************************************/
+unsigned char buttonEvent(void) {
+    unsigned char event = buttonPending;
+    buttonPending = BUTTON_NONE;
+    return event;
+}
+
+/************************************************
+ *  Function to discard button presses made during a blocking menu
+ *  Buttons still held are ignored until they are released
+ ***********************************************/
+void buttonFlush(void) {
+    buttonPending = BUTTON_NONE;
+    buttonSeen = 0x80;
+    buttonHeld = 0;
+}
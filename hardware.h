@@ -1,7 +1,7 @@
 #ifndef _hardware_H
 #define _hardware_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define _XTAL_FREQ 64000000         // note intrinsic _delay function is 62.5ns at 64,000,000Hz  
 #define RED_LED LATGbits.LATG1      // set name for red LED in array
@@ -16,9 +16,21 @@
 #define BUTTON_RF2 PORTFbits.RF2    // set name for RF2 button
 #define BUTTON_RF3 PORTFbits.RF3    // set name for RF3 button
 
+#define BUTTON_NONE 0               // no button event
+#define BUTTON_PRESS_RF2 1          // RF2 pressed and released
+#define BUTTON_PRESS_RF3 2          // RF3 pressed and released
+#define BUTTON_PRESS_BOTH 3         // both buttons pressed together and released
+#define BUTTON_HOLD_BOTH 4          // both buttons held for BUTTON_HOLD samples and released
+#define BUTTON_DEBOUNCE 3           // samples a change must be stable for to be accepted
+#define BUTTON_HOLD 100             // samples both buttons must be held for a long press
+#define BUTTON_PERIOD 10            // ms between button samples
+
 void hardware_init(void);
 void LED_on(void);
 void LED_off(void);
 void LED_flash(unsigned char num);
+void buttonTask(void);
+unsigned char buttonEvent(void);
+void buttonFlush(void);
 
 #endif
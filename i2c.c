@@ -1,5 +1,27 @@
-#include <xc.h>
+#include "hal.h"
 #include "i2c.h"
+#include "structures.h"
+#include "timers.h"
+
+// states of the transaction engine, named after the bus event that has just completed
+#define I2C_IDLE        0
+#define I2C_START_SENT  1
+#define I2C_ADDR_W_SENT 2
+#define I2C_CMD_SENT    3
+#define I2C_DATA_SENT   4
+#define I2C_RSTART_SENT 5
+#define I2C_ADDR_R_SENT 6
+#define I2C_RECEIVING   7
+#define I2C_ACK_SENT    8
+#define I2C_STOP_SENT   9
+
+static I2C_XFER queue[I2C_QUEUE_SIZE];       // circular queue of pending transactions
+static volatile unsigned char queueHead = 0; // index of the active transaction (written by the engine only)
+static volatile unsigned char queueTail = 0; // index of the next free slot (written with the engine held off)
+static volatile unsigned char state = I2C_IDLE;
+static unsigned char byteIndex;              // position within the active transaction data buffer
+static unsigned char failed = 0;             // set while the callback of a failed transaction runs
+static unsigned char nacked = 0;             // set when a byte of the active transaction was not acknowledged
 
 /************************************************
  *  Function to inialise I2C module and pins
@@ -19,10 +41,13 @@ void I2C_2_Master_Init(void) {
     SSP2CLKPPS = 0x1E;                       // pin RD6
     RD5PPS = 0x1C;                           // data output
     RD6PPS = 0x1B;                           // clock output
+
+    PIR3bits.SSP2IF = 0;                     // clear any stale bus event for the transaction engine
 }
 
 /************************************************
  *  Function to wait until I2C is idle
+ *  Note the blocking byte functions below must not be used while the transaction engine is busy
  ***********************************************/
 void I2C_2_Master_Idle(void) {
     while ((SSP2STAT & 0x04) || (SSP2CON2 & 0x1F)); // wait until bus is idle
@@ -74,3 +99,243 @@ unsigned char I2C_2_Master_Read(unsigned char ack) {
     SSP2CON2bits.ACKEN = 1;     // start acknowledge sequence
     return tmp;
 }
+
+/************************************************
+ *  Function to add a transaction to the queue
+ *  The transaction is copied, but the data buffer and done flag must stay valid until completion
+ *  Returns 1 if the transaction was queued, 0 if the queue is full or it reads no bytes
+ ***********************************************/
+unsigned char I2C_2_Master_Queue(I2C_XFER *xfer) {
+    return I2C_2_Master_QueueAll(xfer, 1);
+}
+
+/************************************************
+ *  Function to add 'count' consecutive transactions to the queue, all or none
+ *  The engine is held off for the whole update, so completion callbacks in the
+ *  MSSP2 interrupt may queue transactions too
+ *  Returns 1 if every transaction was queued, 0 if there was not room for them all
+ *  or one of them is a read of no bytes
+ ***********************************************/
+unsigned char I2C_2_Master_QueueAll(I2C_XFER *xfer, unsigned char count) {
+    for (unsigned char i = 0; i < count; i++) {
+        if (xfer[i].read && !xfer[i].length) {return 0;}    // a read must receive at least one byte
+    }
+
+    PIE3bits.SSP2IE = 0;                     // hold off the engine while the queue is updated
+
+    unsigned char used = queueTail >= queueHead ? queueTail - queueHead : queueTail + I2C_QUEUE_SIZE - queueHead;
+    if (used + count >= I2C_QUEUE_SIZE) {    // queue full (one slot is kept empty)
+        PIE3bits.SSP2IE = 1;
+        return 0;
+    }
+
+    for (unsigned char i = 0; i < count; i++) {
+        if (xfer[i].done) {*(xfer[i].done) = 0;}     // clear the completion flag
+        queue[queueTail] = xfer[i];                  // copy the transaction into the free slot
+        queueTail = queueTail + 1 >= I2C_QUEUE_SIZE ? 0 : queueTail + 1;
+    }
+
+    if (state == I2C_IDLE) {
+        state = I2C_START_SENT;
+        SSP2CON2bits.SEN = 1;                // initiate start condition for the new transaction
+    }
+    PIE3bits.SSP2IE = 1;
+    return 1;
+}
+
+/************************************************
+ *  Function to complete the active transaction and drop it from the queue
+ *  The callback runs with I2C_2_Master_Failed set unless result is I2C_DONE_OK
+ ***********************************************/
+static void complete(unsigned char result) {
+    I2C_XFER *x = &queue[queueHead];         // active transaction
+
+    failed = (result != I2C_DONE_OK);
+    if (x->done) {*(x->done) = result;}     // flag the transaction as complete
+    if (x->callback) {x->callback();}       // the callback checks I2C_2_Master_Failed
+    failed = 0;
+    queueHead = queueHead + 1 >= I2C_QUEUE_SIZE ? 0 : queueHead + 1;
+}
+
+/************************************************
+ *  Function to start the next queued transaction, or go idle
+ ***********************************************/
+static void startNext(void) {
+    if (queueHead != queueTail) {
+        SSP2CON2bits.SEN = 1;                // initiate start condition
+        state = I2C_START_SENT;
+    } else {
+        state = I2C_IDLE;
+    }
+}
+
+/************************************************
+ *  Function to advance the transaction engine by one bus event
+ *  Called from the MSSP2 interrupt, or polled while interrupts are disabled
+ ***********************************************/
+void I2C_2_Master_Service(void) {
+    // bus collision, the MSSP has given up the bus and gone idle, so the transaction is lost
+    if (PIR3bits.BCL2IF) {
+        PIR3bits.BCL2IF = 0;
+        PIR3bits.SSP2IF = 0;
+        if (state != I2C_IDLE) {
+            complete(I2C_DONE_ERROR);
+            startNext();
+        }
+        return;
+    }
+
+    if (!PIR3bits.SSP2IF) {return;}          // no bus event has completed
+    PIR3bits.SSP2IF = 0;                     // clear the interrupt flag
+
+    I2C_XFER *x = &queue[queueHead];         // active transaction
+
+    // a byte written was not acknowledged, abandon the transaction with a stop
+    if ((state == I2C_ADDR_W_SENT || state == I2C_CMD_SENT || state == I2C_DATA_SENT || state == I2C_ADDR_R_SENT)
+            && SSP2CON2bits.ACKSTAT) {
+        nacked = 1;
+        SSP2CON2bits.PEN = 1;                // initiate stop condition
+        state = I2C_STOP_SENT;
+        return;
+    }
+
+    switch (state) {
+        case I2C_START_SENT:
+            SSP2BUF = x->address | 0x00;     // 7 bit device address + Write mode
+            state = I2C_ADDR_W_SENT;
+            break;
+
+        case I2C_ADDR_W_SENT:
+            SSP2BUF = x->command;            // command + register address
+            state = I2C_CMD_SENT;
+            break;
+
+        case I2C_CMD_SENT:
+            byteIndex = 0;
+            if (x->read) {
+                SSP2CON2bits.RSEN = 1;       // initiate repeated start condition
+                state = I2C_RSTART_SENT;
+                break;
+            }
+            // fall through to send the write data
+
+        case I2C_DATA_SENT:
+            if (byteIndex < x->length) {
+                SSP2BUF = x->data[byteIndex++];
+                state = I2C_DATA_SENT;
+            } else {
+                SSP2CON2bits.PEN = 1;        // initiate stop condition
+                state = I2C_STOP_SENT;
+            }
+            break;
+
+        case I2C_RSTART_SENT:
+            SSP2BUF = x->address | 0x01;     // 7 bit device address + Read mode
+            state = I2C_ADDR_R_SENT;
+            break;
+
+        case I2C_ACK_SENT:
+            if (byteIndex >= x->length) {
+                SSP2CON2bits.PEN = 1;        // initiate stop condition
+                state = I2C_STOP_SENT;
+                break;
+            }
+            // fall through to receive the next byte
+
+        case I2C_ADDR_R_SENT:
+            SSP2CON2bits.RCEN = 1;           // put the module into receive mode
+            state = I2C_RECEIVING;
+            break;
+
+        case I2C_RECEIVING:
+            x->data[byteIndex++] = SSP2BUF;  // read data from SSP2BUF
+            SSP2CON2bits.ACKDT = (byteIndex >= x->length);  // don't acknowledge the last read
+            SSP2CON2bits.ACKEN = 1;          // start acknowledge sequence
+            state = I2C_ACK_SENT;
+            break;
+
+        case I2C_STOP_SENT:
+            complete(nacked ? I2C_DONE_NACK : I2C_DONE_OK);
+            nacked = 0;
+            startNext();
+            break;
+
+        default:
+            state = I2C_IDLE;
+            break;
+    }
+}
+
+/************************************************
+ *  Function to service the engine when the MSSP2 interrupt cannot run
+ ***********************************************/
+void I2C_2_Master_Poll(void) {
+    if (!INTCONbits.GIE) {I2C_2_Master_Service();}
+}
+
+/************************************************
+ *  Function to check if any transaction is in flight or queued
+ *  1: engine busy
+ *  0: engine idle
+ ***********************************************/
+unsigned char I2C_2_Master_Busy(void) {
+    return (state != I2C_IDLE);
+}
+
+/************************************************
+ *  Function to check, from a completion callback, if the transaction failed
+ *  1: a byte was not acknowledged or the bus was lost, the data buffer is not valid
+ *  0: transaction completed
+ ***********************************************/
+unsigned char I2C_2_Master_Failed(void) {
+    return failed;
+}
+
+/************************************************
+ *  Function to recover from a stuck bus
+ *  Restarts the MSSP, which releases the bus, and completes every transaction
+ *  queued so far with I2C_DONE_ERROR. Transactions queued by their callbacks
+ *  then run on the reset bus
+ ***********************************************/
+void I2C_2_Master_Abort(void) {
+    PIE3bits.SSP2IE = 0;                     // hold off the engine
+    SSP2CON1bits.SSPEN = 0;                  // reset the module and release SDA and SCL
+    SSP2CON2 = 0;                            // no condition or receive pending
+    SSP2CON1bits.SSPEN = 1;
+    PIR3bits.SSP2IF = 0;
+    PIR3bits.BCL2IF = 0;
+    nacked = 0;
+
+    // the engine is left busy meanwhile, so a callback that queues does not start the bus
+    unsigned char tail = queueTail;
+    while (queueHead != tail) {complete(I2C_DONE_ERROR);}
+    startNext();                             // transactions queued by the callbacks
+    PIE3bits.SSP2IE = 1;
+}
+
+/************************************************
+ *  Function to queue a transaction and wait for it to complete
+ *  If the engine makes no progress for I2C_TIMEOUT ticks the bus is reset
+ *  with I2C_2_Master_Abort, so a stuck bus can not hang the caller
+ *  1: transaction completed
+ *  0: a byte was not acknowledged, or the bus was lost
+ ***********************************************/
+unsigned char I2C_2_Master_Transfer(I2C_XFER *xfer) {
+    volatile unsigned char done = 0;
+    volatile unsigned char *userDone = xfer->done;
+    unsigned long deadline = getTicks() + I2C_TIMEOUT;
+
+    xfer->done = &done;
+    while (!I2C_2_Master_Queue(xfer)) {      // wait for a free slot
+        I2C_2_Master_Poll();
+        if (deadlineReached(deadline)) {I2C_2_Master_Abort();}  // empties the queue
+    }
+    deadline = getTicks() + I2C_TIMEOUT;
+    while (!done) {                          // wait for completion
+        I2C_2_Master_Poll();
+        if (deadlineReached(deadline)) {I2C_2_Master_Abort();}  // completes this transaction as failed
+    }
+    xfer->done = userDone;
+    if (userDone) {*userDone = done;}
+    return done == I2C_DONE_OK;
+}
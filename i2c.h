@@ -1,10 +1,16 @@
 #ifndef _i2c_H
 #define _i2c_H
 
-#include <xc.h>
+#include "hal.h"
+#include "structures.h"
 
 #define _XTAL_FREQ 64000000 // note intrinsic _delay function is 62.5ns at 64,000,000Hz  
 #define _I2C_CLOCK 100000   // 100kHz for I2C
+#define I2C_QUEUE_SIZE 4    // number of slots in the transaction queue (one is kept empty)
+#define I2C_DONE_OK 1       // done flag value for a completed transaction
+#define I2C_DONE_NACK 2     // done flag value for a transaction abandoned when a byte was not acknowledged
+#define I2C_DONE_ERROR 3    // done flag value for a transaction lost to a bus collision or a stuck bus
+#define I2C_TIMEOUT 20      // ticks (ms) I2C_2_Master_Transfer waits for its transaction before resetting the bus
 
 void I2C_2_Master_Init(void);
 void I2C_2_Master_Idle(void);
@@ -14,4 +20,14 @@ void I2C_2_Master_Stop(void);
 void I2C_2_Master_Write(unsigned char data_byte);
 unsigned char I2C_2_Master_Read(unsigned char ack);
 
+// interrupt driven transaction engine
+unsigned char I2C_2_Master_Queue(I2C_XFER *xfer);
+unsigned char I2C_2_Master_QueueAll(I2C_XFER *xfer, unsigned char count);
+void I2C_2_Master_Service(void);
+void I2C_2_Master_Poll(void);
+unsigned char I2C_2_Master_Busy(void);
+unsigned char I2C_2_Master_Failed(void);
+void I2C_2_Master_Abort(void);
+unsigned char I2C_2_Master_Transfer(I2C_XFER *xfer);
+
 #endif
@@ -1,11 +1,21 @@
-#include <xc.h>
+#include "hal.h"
+#include "dc_motor.h"
+#include "i2c.h"
 #include "interrupts.h"
+#include "odometry.h"
+#include "profile.h"
+#include "serial.h"
+#include "timers.h"
 
 /************************************
  * Function to turn on interrupts and set if priority is used
 ************************************/
 void Interrupts_init(void) {    
     PIE0bits.TMR0IE = 1;  // enable timer overflow interrupt source
+    PIE3bits.SSP2IE = 1;  // enable MSSP2 (I2C) bus event interrupt source
+    PIE3bits.BCL2IE = 1;  // enable MSSP2 bus collision interrupt source
+    PIE5bits.TMR4IE = 1;  // enable control tick interrupt source
+    PIE4bits.RC4IE = 1;   // enable serial receive interrupt source (transmit is enabled by sendTxBuf)
     INTCONbits.PEIE = 1;  // turn on peripheral interrupts
     INTCONbits.GIE = 1;   // turn on interrupts globally - KEEP LAST
 }
@@ -16,9 +26,44 @@ void Interrupts_init(void) {
 void __interrupt(high_priority) HighISR() {
     // timer interrupt flag
     if (PIR0bits.TMR0IF) {                  // check the timer interrupt source
-        LATHbits.LATH3 = !LATHbits.LATH3;   // toggle LED
-        TMR0H = 0;                          // reset the timer
-        TMR0L = 0;
+        LATHbits.LATH3 = !LATHbits.LATH3;   // toggle the heartbeat LED, timer 0 wraps to 0 by itself
         PIR0bits.TMR0IF = 0;                // clear the interupt flag
     }
+    
+    // control tick flag
+    if (PIR5bits.TMR4IF) {                  // check the control tick source
+        clockTick();                        // advance the 1ms tick clock
+        motorTask();                        // step the motor ramps
+        odomTask();                         // advance the wheel odometers
+        PIR5bits.TMR4IF = 0;                // clear the interupt flag
+    }
+    
+#ifdef PROFILE_ENABLE
+    // profiling cycle counter overflow
+    if (PIR5bits.TMR1IF) {
+        profileOverflow();                  // extend the counter to 32 bits
+        PIR5bits.TMR1IF = 0;                // clear the interupt flag
+    }
+    
+#endif
+    // I2C bus event flag
+    if (PIE3bits.SSP2IE && (PIR3bits.SSP2IF || PIR3bits.BCL2IF)) {   // check the MSSP2 sources (masked while the queue is updated)
+        I2C_2_Master_Service();             // advance the I2C transaction engine (clears the flags)
+    }
+    
+    // serial transmit register empty, send the next buffered byte
+    if (PIE4bits.TX4IE && PIR4bits.TX4IF) {
+        if (isDataInTxBuf()) {TX4REG = getCharFromTxBuf();}
+        else {PIE4bits.TX4IE = 0;}          // buffer drained, stop until sendTxBuf is called again
+    }
+    
+    // serial byte received
+    if (PIR4bits.RC4IF) {
+        if (RC4STAbits.OERR) {              // hardware overrun, restart the receiver
+            RC4STAbits.CREN = 0;
+            RC4STAbits.CREN = 1;
+            RxBufOverflow++;
+        }
+        putCharToRxBuf(RC4REG);             // reading RC4REG clears the flag
+    }
 }
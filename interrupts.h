@@ -1,7 +1,7 @@
 #ifndef _interrupts_H
 #define _interrupts_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define _XTAL_FREQ 64000000
 
@@ -6,50 +6,65 @@
 #pragma config WDTCPS = WDTCPS_31// WDT Period Select bits (Divider ratio 1:65536; software control of WDTPS)
 #pragma config WDTE = OFF        // WDT operating mode (WDT enabled regardless of sleep)
 
-#include <xc.h>
+#include "hal.h"
 #include <stdio.h>
+#include "classifier.h"
 #include "color.h"
 #include "dc_motor.h"
+#include "filter.h"
 #include "hardware.h"
 #include "i2c.h"
 #include "interrupts.h"
+#include "map.h"
+#include "navigate.h"
+#include "profile.h"
+#include "scheduler.h"
 #include "sequence.h"
+#include "serial.h"
 #include "structures.h"
 #include "timers.h"
 
 void main(void){
-    color_click_init();   // initialise the color click board
     hardware_init();      // initialise all other hardware
     I2C_2_Master_Init();  // initialise I2C functionality
     Timer0_init();        // initialise timer0 hardware
+    Timer4_init();        // initialise timer4 control tick
+    initUSART4();         // initialise the serial telemetry link
+    profileInit();        // start the profiling cycle counter (debug builds only)
+    initDCmotorsPWM(PWM_FREQ);  // initialise DC motor control before the control tick can step it
+    turnsLoad();          // load the calibrated turn table from EEPROM
+    trimLoad();           // load the calibrated motor trim from EEPROM
     Interrupts_init();    // initialisation of interrupts
-    initDCmotorsPWM(99);  // initialise DC motor control
+    color_click_init();   // initialise the color click board, with the tick running so a stuck bus times out
     
     DATA data_struct;                  // declare the data structure to store all information
     SEQUENCE sequence;                 // declare the sequence structure
     data_struct.sequence = &sequence;  // assign the data structure pointer to the sequence structure
+    CLASSIFIER classifier;                 // declare the classifier structure
+    data_struct.classifier = &classifier;  // assign the data structure pointer to the classifier structure
+    FILTER filter;                         // declare the sample filter structure
+    data_struct.filter = &filter;          // assign the data structure pointer to the filter structure
+    filterReset(&filter);
+    MAP map;                               // declare the grid map structure
+    data_struct.map = &map;                // assign the data structure pointer to the map structure
+    mapReset(&map);
 
     data_struct.sequence->index = 0;   // declare move index zero
     data_struct.backtrack = 0;         // declare backtrack state zero
     data_struct.count = 0;             // declare count state zero
+    
+    // load the stored color calibration, the main beam flashes while RF3 calibration is needed
+    navInit(&data_struct, loadCalibration(&data_struct));
+    
+    // periodic tasks, run in this order on each pass so each sees the previous task's output
+    // (the motor ramps run from the timer4 interrupt)
+    schedulerAdd(sensorTask, SENSOR_PERIOD);        // background colour sampling
+    schedulerAdd(navTask, NAV_PERIOD);              // navigation state machine
+    schedulerAdd(telemetryTask, TELEMETRY_PERIOD);  // telemetry of each sample
+    schedulerAdd(buttonTask, BUTTON_PERIOD);        // button debounce
+    schedulerAdd(ledTask, LED_PERIOD);              // status LEDs
          
     while (1){       
-        // main loop for navigating the maze
-        if (!BUTTON_RF2) {
-            // main navigation loop to find the white wall
-            while (data_struct.backtrack == 0) {
-                move2wall(&data_struct);
-                __delay_ms(1000);
-                colorAction(&data_struct);
-            }
-            
-            // backtrack to the start of the maze
-            backtrack(&data_struct);
-        }
-        
-        // calibration loop
-        if (!BUTTON_RF3) {storeCalibration(&data_struct);}
+        schedulerRun();
     }
 }
-        
-       
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "hal.h"
+#include "map.h"
+#include "sequence.h"
+#include "structures.h"
+
+// cell offsets of the 8 headings, clockwise from the start heading (north)
+static const signed char dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const signed char dy[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+
+static unsigned char via[MAP_SIZE * MAP_SIZE / 2];  // search result, 4 bits per cell: 0 unreached, heading to the start + 1 or MAP_HOME
+static unsigned char queue[MAP_SIZE * MAP_SIZE];    // search queue of cells, reused for the path home
+
+/************************************************
+ *  Function to find the cell next to a cell in a heading
+ *  Returns 0 if the neighbour is off the map
+ ***********************************************/
+static unsigned char neighbour(unsigned char cell, unsigned char heading, unsigned char *next) {
+    unsigned char x = (cell % MAP_SIZE) + dx[heading];
+    unsigned char y = (cell / MAP_SIZE) + dy[heading];
+    if (x >= MAP_SIZE || y >= MAP_SIZE) {return 0;}     // also catches -1, which wraps to 255
+    *next = y * MAP_SIZE + x;
+    return 1;
+}
+
+/************************************************
+ *  Function to find the bit of the passage leaving a cell in a heading
+ *  Passages to the south and west are stored in the neighbouring cell
+ *  Returns 0 if the passage leaves the map
+ ***********************************************/
+static unsigned char passage(unsigned char cell, unsigned char heading, unsigned char *byte, unsigned char *bit) {
+    if (heading >= 4) {
+        if (!neighbour(cell, heading, &cell)) {return 0;}
+        heading -= 4;
+    }
+    *byte = cell >> 1;
+    *bit = 1 << ((cell & 1) * 4 + heading);
+    return 1;
+}
+
+/************************************************
+ *  Function to check whether the buggy has driven from a cell in a heading
+ ***********************************************/
+static unsigned char isOpen(MAP *map, unsigned char cell, unsigned char heading) {
+    unsigned char byte, bit;
+    if (!passage(cell, heading, &byte, &bit)) {return 0;}
+    return (map->open[byte] & bit) != 0;
+}
+
+/************************************************
+ *  Function to read and write the 4 bit search entry of a cell
+ ***********************************************/
+static unsigned char getVia(unsigned char cell) {
+    return cell & 1 ? via[cell >> 1] >> 4 : via[cell >> 1] & 0x0F;
+}
+
+static void setVia(unsigned char cell, unsigned char value) {
+    if (cell & 1) {via[cell >> 1] = (via[cell >> 1] & 0x0F) | (value << 4);}
+    else {via[cell >> 1] = (via[cell >> 1] & 0xF0) | value;}
+}
+
+/************************************************
+ *  Function to clear the map and place the buggy in the middle, facing north
+ ***********************************************/
+void mapReset(MAP *map) {
+    for (unsigned char i = 0; i < sizeof(map->open); i++) {map->open[i] = 0;}
+    map->x = MAP_SIZE / 2;
+    map->y = MAP_SIZE / 2;
+    map->heading = 0;
+    map->valid = 1;
+    map->travelled = 0;
+}
+
+/************************************************
+ *  Function to update the buggy position and the passages from a move
+ *  A straight is rounded to whole squares (diagonal squares are sqrt(2) longer),
+ *  so backing away from a wall does not leave the square
+ ***********************************************/
+void mapMove(MAP *map, MOVE *m) {
+    if (!map->valid) {return;}
+    
+    if (moveType(m)) {
+        unsigned char step = movePower(m) / 45;
+        map->heading = (moveDirection(m) ? map->heading + step : map->heading - step) & 7;
+        return;
+    }
+    
+    unsigned int length = map->heading & 1 ? ((unsigned long)MAP_CELL * 362) >> 8 : MAP_CELL;
+    unsigned char n = ((unsigned long)m->distance + length / 2) / length;  // long so a near full scale distance can not wrap
+    unsigned char heading = moveDirection(m) ? map->heading : (map->heading + 4) & 7;
+    unsigned char cell = map->y * MAP_SIZE + map->x;
+    
+    for (; n > 0; n--) {
+        unsigned char next, byte, bit;
+        if (!neighbour(cell, heading, &next)) {         // left the map, it can no longer be trusted
+            map->valid = 0;
+            return;
+        }
+        passage(cell, heading, &byte, &bit);
+        map->open[byte] |= bit;
+        cell = next;
+        map->travelled++;
+    }
+    map->x = cell % MAP_SIZE;
+    map->y = cell / MAP_SIZE;
+}
+
+/************************************************
+ *  Function to add a turn between two headings to the sequence
+ ***********************************************/
+static void planTurn(DATA *data, unsigned char from, unsigned char to) {
+    unsigned char step = (to - from) & 7;
+    if (step == 0) {return;}
+    if (step <= 4) {addMove(data, 1, 1, step * 45, 0);}
+    else {addMove(data, 1, 0, (8 - step) * 45, 0);}
+}
+
+/************************************************
+ *  Function to replace the sequence with the shortest known path home
+ *  A breadth first search from the start over the passages driven finds the
+ *  heading back towards the start from every reachable cell. If the path from
+ *  the current cell is shorter than the distance explored, the sequence is
+ *  rewritten as the moves from the start along that path, so backtrack can
+ *  replay it in reverse as usual. The map is used up, it is only valid once.
+ *  Returns 1 if the sequence was replaced
+ ***********************************************/
+unsigned char mapPlanHome(DATA *data) {
+    MAP *map = data->map;
+    if (!map->valid) {return 0;}
+    map->valid = 0;                         // stop the planned moves being mapped
+    
+    // search outwards from the start
+    for (unsigned char i = 0; i < sizeof(via); i++) {via[i] = 0;}
+    unsigned char home = (MAP_SIZE / 2) * MAP_SIZE + MAP_SIZE / 2;
+    unsigned int head = 0, tail = 0;
+    queue[tail++] = home;
+    setVia(home, MAP_HOME);
+    while (head < tail) {
+        unsigned char cell = queue[head++];
+        for (unsigned char h = 0; h < 8; h++) {
+            unsigned char next;
+            if (!isOpen(map, cell, h) || !neighbour(cell, h, &next) || getVia(next)) {continue;}
+            setVia(next, ((h + 4) & 7) + 1);   // the way back towards the start
+            queue[tail++] = next;
+        }
+    }
+    
+    // follow the search back from the current cell, the headings are stored in reverse
+    unsigned char cell = map->y * MAP_SIZE + map->x;
+    unsigned int steps = 0;
+    while (getVia(cell) != MAP_HOME) {
+        unsigned char v = getVia(cell);
+        if (v == 0) {return 0;}             // not connected to the start, keep the sequence
+        queue[steps++] = v - 1;
+        neighbour(cell, v - 1, &cell);
+    }
+    if (steps >= map->travelled) {return 0;}  // no shorter than the path explored
+    
+    // rewrite the sequence as the path driven forwards from the start
+    data->sequence->index = 0;
+    unsigned char heading = 0;
+    while (steps > 0) {
+        unsigned char h = (queue[steps - 1] + 4) & 7;   // heading away from the start
+        unsigned char run = 0;
+        while (steps > 0 && ((queue[steps - 1] + 4) & 7) == h) {
+            run++;
+            steps--;
+        }
+        
+        planTurn(data, heading, h);
+        heading = h;
+        unsigned int length = h & 1 ? ((unsigned long)MAP_CELL * 362) >> 8 : MAP_CELL;
+        addMove(data, 0, 1, MAP_POWER, run * length);
+    }
+    planTurn(data, heading, map->heading);
+    return 1;
+}
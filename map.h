@@ -0,0 +1,17 @@
+#ifndef _map_H
+#define _map_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+#define MAP_CELL 1560         // odometer steps per square, the 2.5s reverse at power 20 used for yellow and pink
+#define MAP_POWER 50          // power of the straights in a planned path home
+#define MAP_HOME 9            // marks the start cell in the search (directions are stored as 1-8)
+
+void mapReset(MAP *map);
+void mapMove(MAP *map, MOVE *m);
+unsigned char mapPlanHome(DATA *data);
+
+#endif
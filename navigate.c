@@ -0,0 +1,404 @@
+#include "hal.h"
+#include "color.h"
+#include "dc_motor.h"
+#include "filter.h"
+#include "hardware.h"
+#include "map.h"
+#include "navigate.h"
+#include "odometry.h"
+#include "profile.h"
+#include "sequence.h"
+#include "structures.h"
+#include "telemetry.h"
+#include "timers.h"
+
+static DATA *nav;                           // data structure shared by the tasks
+static unsigned char navState = NAV_IDLE;   // current navigation state
+static unsigned char navNext;               // state entered once the buggy has come to rest
+static unsigned long navDeadline;           // tick count that ends the push into the wall, the ambient wait or a turn
+static unsigned char sampleNew = 0;         // set when data holds a sample navigation has not used
+static unsigned char sampleUnsent = 0;      // set when data holds a sample telemetry has not sent
+static unsigned char calibrated;            // 0 while no colour calibration is stored
+
+// wall approach
+static unsigned char power;                 // approach power
+static unsigned int lower, upper;           // clear channel thresholds either side of ambient
+
+static unsigned char decision;              // colour of the current card
+static unsigned long mark;                  // odometer reading at the start of the current straight
+static unsigned int reverseSteps;           // odometer steps NAV_REVERSING backs away
+static unsigned int turnHold;               // full power time (ms) of the current turn
+
+// samples taken pressed against the card, voted on while the buggy backs away
+static RGB contact[COLOR_VOTE_SAMPLES];     // newest first
+static unsigned char contactCount;          // samples captured
+static unsigned char contactVoted;          // samples the vote has used
+
+/************************************************
+ *  Function to set up the navigation tasks
+ ***********************************************/
+void navInit(DATA *data, unsigned char isCalibrated) {
+    nav = data;
+    calibrated = isCalibrated;
+    navState = NAV_IDLE;
+}
+
+/************************************************
+ *  Function to wait without blocking, navTask enters next once the
+ *  motors have ramped down and the wheels have stopped coasting
+ ***********************************************/
+static void navSettle(unsigned char next) {
+    navNext = next;
+    navState = NAV_SETTLE;
+}
+
+/************************************************
+ *  Function to back away at REVERSE_POWER without blocking, navTask
+ *  enters next once the buggy has covered steps and come to rest
+ ***********************************************/
+static void navReverse(unsigned int steps, unsigned char next) {
+    mark = odomRead();
+    reverseSteps = steps;
+    navNext = next;
+    straight(0, REVERSE_POWER);
+    navState = NAV_REVERSING;
+}
+
+/************************************************
+ *  Function to turn on the spot without blocking, navTask holds the turn
+ *  for its calibrated time and enters next once the buggy has come to rest
+ ***********************************************/
+static void navRotate(unsigned char direction, unsigned char angle, unsigned char next) {
+    turnHold = turnStart(direction, angle);
+    navNext = next;
+    navState = NAV_TURNING;
+}
+
+/************************************************
+ *  Function to capture the samples taken against the card and vote on the newest
+ *  The ring holds one sample per integration, so each is an independent
+ *  reading. The newest was taken pressed against the card, older samples
+ *  only count if they are as bright, as samples taken on the way in see less
+ *  of the LEDs. The newest sample is the one telemetry sends next, so it is
+ *  voted on here and tagged with its class
+ ***********************************************/
+static void navCapture(void) {
+    SAMPLE *s;
+    unsigned int level = nav->rgb.c - (nav->rgb.c >> CONTACT_SHIFT);
+    contactCount = 0;
+    while (contactCount < COLOR_VOTE_SAMPLES && (s = filterSample(nav->filter, contactCount)) != 0
+           && s->rgb.c >= level) {
+        contact[contactCount++] = s->rgb;
+    }
+    contactVoted = 1;
+    decision = detectVote(nav->classifier, &nav->hsv, &nav->decision, &nav->margin);   // nav->hsv is the newest sample
+}
+
+/************************************************
+ *  Function to vote on the next captured contact sample, one per pass
+ *  The sample in nav belongs to telemetry, so the reading, class and margin
+ *  are kept here. Takes the leading colour if the captured samples run out
+ *  before the vote is decided
+ ***********************************************/
+static void navClassify(void) {
+    if (decision != COLOR_UNDECIDED) {return;}
+    if (contactVoted >= contactCount) {
+        decision = detectLeader();
+        return;
+    }
+    HSV hsv = rgb2hsv(contact[contactVoted++]);
+    unsigned char cls;
+    unsigned int margin;
+    decision = detectVote(nav->classifier, &hsv, &cls, &margin);
+}
+
+/************************************************
+ *  Function to keep the background colour sampler running
+ *  Each new sample is converted to HSV and stored in the data structure
+ ***********************************************/
+void sensorTask(void) {
+    color_start_sample();                   // queue a background read if one is not already in flight
+    if (!color_sample_ready()) {return;}
+
+    PROF_START(PROF_SAMPLE);
+    nav->rgb = color_latest();
+    nav->hsv = rgb2hsv(nav->rgb);
+    filterAdd(nav->filter, nav->rgb, getTicks());
+    nav->decision = TELEMETRY_NO_CLASS;     // navigation classifies it if it needs to
+    sampleNew = 1;
+    sampleUnsent = 1;
+    PROF_END(PROF_SAMPLE);
+}
+
+/************************************************
+ *  Function to send each new sample over the telemetry link
+ ***********************************************/
+void telemetryTask(void) {
+    if (!sampleUnsent) {return;}
+    sampleUnsent = 0;
+    telemetrySample(nav);
+}
+
+/************************************************
+ *  Function to show the buggy status, the main beam flashes until calibrated
+ ***********************************************/
+void ledTask(void) {
+    if (!calibrated) {MAIN_BEAM = !MAIN_BEAM;}
+}
+
+/************************************************
+ *  Function to handle a button event while idle
+ ***********************************************/
+static void navButtons(void) {
+    switch (buttonEvent()) {
+        case BUTTON_PRESS_RF2:  // start a new run through the maze
+            nav->sequence->index = 0;
+            mapReset(nav->map);
+            nav->backtrack = 0;
+            nav->count = 0;
+            navState = NAV_NEXT;
+            break;
+
+        case BUTTON_PRESS_RF3:  // colour calibration
+            storeCalibration(nav);
+            calibrated = 1;
+            MAIN_BEAM = 0;
+            buttonFlush();
+            break;
+
+        case BUTTON_HOLD_BOTH:  // profile dump in debug builds, trim and turn calibration otherwise
+#ifdef PROFILE_ENABLE
+            profileDump();
+            break;
+#endif
+        case BUTTON_PRESS_BOTH: // motor trim then turn calibration
+            calibrateTrim();
+            calibrateTurns();
+            buttonFlush();
+            break;
+    }
+}
+
+/************************************************
+ *  Function to give the distance of the current straight in recorded steps,
+ *  including the coast to rest still to come
+ ***********************************************/
+static unsigned int navDistance(void) {
+    return odomSteps(odomSince(mark) + odomStopping());
+}
+
+/************************************************
+ *  Function to move the buggy towards the wall, called for each new sample
+ *  Cruises at high power while the clear channel is near ambient and decelerates
+ *  as it approaches the threshold, the move is stored with the odometer distance
+ *  The wall test uses the median of the last three samples, so a single noisy
+ *  reading can not stop the buggy, and the slowdown uses the averaged gradient
+ ***********************************************/
+static void navApproach(void) {
+    PROF_START(PROF_APPROACH);
+    unsigned int c = filterMedian(nav->filter).c;
+
+    // stop the buggy if the clear channel exits the threshold
+    if (c < nav->ambLight - lower || c > nav->ambLight + upper) {
+        // do not store the movement if the color was not previously detected
+        if (nav->count == 0) {
+            addMove(nav, 0, 1, APPROACH_MIN, navDistance() + ALIGN_DISTANCE);  // add movement towards the wall in the forward sequence
+        }
+
+        navState = NAV_ALIGN;   // push on into the wall without stopping
+        return;                 // the final step is not profiled
+    }
+
+    // slow down as the wall gets closer
+    power = approachPower(c, filterSlope(nav->filter), nav->ambLight, lower, upper);
+    straight(1, power);
+    PROF_END(PROF_APPROACH);
+}
+
+/************************************************
+ *  Function to carry out the action of the card colour and addMove according to action taken
+ ***********************************************/
+static void navAction(void) {
+    navState = NAV_NEXT;
+
+    switch (decision) {
+        case 0:  // red -> turn right 90 deg
+            navRotate(1, 90, NAV_NEXT);
+            addMove(nav, 1, 1, 90, 0);
+            break;
+
+        case 1:  // green -> turn left 90 deg
+            navRotate(0, 90, NAV_NEXT);
+            addMove(nav, 1, 0, 90, 0);
+            break;
+
+        case 2:  // blue -> turn 180 deg
+            navRotate(0, 180, NAV_NEXT);
+            addMove(nav, 1, 0, 180, 0);
+            break;
+
+        case 3:  // yellow -> reverse 1 square and turn right 90 deg
+        case 4:  // pink -> reverse 1 square and turn left 90 deg
+            navReverse(MAP_CELL, NAV_BACKED_UP);
+            break;
+
+        case 5:  // orange -> turn right 135 deg
+            navRotate(1, 135, NAV_NEXT);
+            addMove(nav, 1, 1, 135, 0);
+            break;
+
+        case 6:  // light blue -> turn left 135 deg
+            navRotate(0, 135, NAV_NEXT);
+            addMove(nav, 1, 0, 135, 0);
+            break;
+
+        case 7:  // white -> finish, 'trigger return to home'
+            nav->backtrack = 1;         // update backtrack flag to return to starting position
+            break;
+
+        case 8:  // no color found (black)
+            nav->count++;
+            if (nav->count >= 3) {      // check if the wall has been detected to be black 3 times
+                nav->backtrack = 1;     // update backtrack flag to return to starting position
+            }
+            break;
+    }
+
+    // reset the counter if a color was found
+    if (decision != 8) {nav->count = 0;}
+}
+
+/************************************************
+ *  Function to advance the navigation state machine
+ *  Every state returns straight away, so sampling, telemetry and the
+ *  buttons keep running while the buggy waits or drives. Waits end on
+ *  measured conditions (the buggy at rest, the sensor stable) rather than fixed delays
+ ***********************************************/
+void navTask(void) {
+    unsigned char fresh = sampleNew;
+    sampleNew = 0;
+
+    switch (navState) {
+        case NAV_IDLE:
+            navButtons();
+            break;
+
+        case NAV_SETTLE:
+            if (motorsSettled() && odomStill()) {navState = navNext;}
+            break;
+
+        case NAV_AMBIENT:
+            color_set_profile(COLOR_PROFILE_APPROACH);  // short integration for fast wall detection
+            color_autorange();                          // pick a gain that does not saturate under the LEDs
+            filterReset(nav->filter);                   // only samples at this gain
+            navDeadline = getTicks() + AMBIENT_MAX;
+            navState = NAV_AMBIENT_STABLE;
+            break;
+
+        case NAV_AMBIENT_STABLE:
+            // the ambient light is the moving average once the reading stops changing (or AMBIENT_MAX passes)
+            if (!fresh) {break;}
+            if (!deadlineReached(navDeadline)) {
+                int slope = filterSlope(nav->filter);
+                if (nav->filter->count <= FILTER_WINDOW) {break;}
+                if ((unsigned int)(slope < 0 ? -slope : slope) > color_scale(AMBIENT_STABLE)) {break;}
+            }
+            nav->ambLight = filterMean(nav->filter).c;
+            navState = NAV_APPROACH_START;
+            break;
+
+        case NAV_APPROACH_START:
+            BRAKE_LED = 0;
+
+            // wall thresholds were tuned with the classify profile, so scale them to the active profile
+            lower = color_scale(13);
+            upper = color_scale(30);
+
+            power = APPROACH_MAX;       // start at cruise power
+            filterReset(nav->filter);   // only samples from this approach
+            mark = odomRead();
+            straight(1, power);         // start moving forward whilst searching for a wall
+            navState = NAV_APPROACH;
+            break;
+
+        case NAV_APPROACH:
+            if (fresh) {navApproach();}
+            break;
+
+        case NAV_ALIGN:
+            // drive into the wall to align buggy, the classify profile starts integrating meanwhile
+            straight(1, ALIGN_POWER);
+            detectStart();              // classify profile, and clear the votes of the last card
+            filterReset(nav->filter);   // no approach profile samples among the contact samples
+            navDeadline = getTicks() + ALIGN_TIME;
+            navState = NAV_CONTACT;
+            break;
+
+        case NAV_CONTACT:
+            // the first sample after the push ended integrated pressed against the card
+            if (!fresh || !deadlineReached(navDeadline)) {break;}
+            navCapture();
+
+            // back away at once, finish the vote and set up the next approach on the way
+            color_set_profile(COLOR_PROFILE_APPROACH);
+            odomHalt();                 // the wheels have stalled against the card, nothing to coast
+            navReverse(REVERSE_DISTANCE, NAV_REVERSED);
+            break;
+
+        case NAV_REVERSING:
+            navClassify();              // finish the vote on the contact samples on the way
+            // stop once the coast to rest will cover the rest of the distance
+            if (odomSince(mark) + odomStopping() < ((long)reverseSteps << ODOM_SHIFT)) {break;}
+            straight(0, 0);             // ramp down without waiting
+            navState = NAV_SETTLE;      // navNext was set by navReverse
+            break;
+
+        case NAV_REVERSED:
+            navClassify();              // finish the vote on the contact samples on the way
+            if (decision == COLOR_UNDECIDED) {break;}   // at rest before the vote finished
+            // do not store the movement if the color was not previously detected
+            if (nav->count == 0) {addMove(nav, 0, 0, REVERSE_POWER, navDistance());}
+            navState = NAV_ACTION;
+            break;
+
+        case NAV_ACTION:
+            navAction();
+            break;
+
+        case NAV_BACKED_UP:
+            addMove(nav, 0, 0, REVERSE_POWER, navDistance());
+            navState = NAV_TURN;
+            break;
+
+        case NAV_TURN:
+            navRotate(decision == 3, 90, NAV_NEXT);     // yellow turns right, pink turns left
+            addMove(nav, 1, decision == 3, 90, 0);
+            break;
+
+        case NAV_TURNING:
+            // the hold time is counted from full turning power, as calibrated
+            if (!motorsSettled()) {break;}
+            navDeadline = getTicks() + turnHold;
+            navState = NAV_TURN_HOLD;
+            break;
+
+        case NAV_TURN_HOLD:
+            if (!deadlineReached(navDeadline)) {break;}
+            motorsStop();               // ramp down without waiting
+            navSettle(navNext);
+            break;
+
+        case NAV_NEXT:
+            if (nav->backtrack) {
+                backtrack(nav);         // backtrack to the start of the maze
+                buttonFlush();
+                navState = NAV_IDLE;
+            } else {
+                // turn on the sensor LEDs and measure ambient once the buggy is at rest after its turn
+                BRAKE_LED = 1;
+                LED_on();
+                navSettle(NAV_AMBIENT);
+            }
+            break;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef _navigate_H
+#define _navigate_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+// navigation states
+#define NAV_IDLE 0            // waiting for a button event
+#define NAV_SETTLE 1          // waiting for the buggy to come to rest before entering navNext
+#define NAV_AMBIENT 2         // select the approach profile and gain with the sensor LEDs on
+#define NAV_AMBIENT_STABLE 3  // measure the ambient light once the reading stops changing
+#define NAV_APPROACH_START 4  // set up the wall approach
+#define NAV_APPROACH 5        // drive towards the wall until the clear channel leaves ambient
+#define NAV_ALIGN 6           // drive into the wall to square up to the card and start classifying
+#define NAV_CONTACT 7         // capture the samples taken against the card, then back away voting on them
+#define NAV_REVERSING 8       // back away until the odometer covers reverseSteps
+#define NAV_REVERSED 9        // record backing away from the wall
+#define NAV_ACTION 10         // carry out the action of the card colour
+#define NAV_BACKED_UP 11      // record reversing a square (yellow and pink)
+#define NAV_TURN 12           // turn after reversing a square (yellow and pink)
+#define NAV_TURNING 13        // wait for the motors to ramp up to turning power
+#define NAV_TURN_HOLD 14      // hold the turn for its calibrated time, then stop and settle into navNext
+#define NAV_NEXT 15           // start the next cell or return home
+
+#define ALIGN_DISTANCE 250    // odometer steps recorded for the push into the wall, which the model can not measure
+#define ALIGN_POWER 40        // power of the push into the wall
+#define ALIGN_TIME 400        // push (ms) before samples are taken as pressed against the card
+#define CONTACT_SHIFT 3       // older samples within 1/8 of the clear channel of the last count as against the card
+#define REVERSE_POWER 20      // power when backing away from a wall or reversing a square
+#define REVERSE_DISTANCE 437  // odometer steps to back away from the wall before turning
+#define AMBIENT_STABLE 3      // moving average change per sample (classify profile counts) taken as stable
+#define AMBIENT_MAX 500       // longest wait (ms) for a stable ambient reading
+
+// task periods (ms)
+#define SENSOR_PERIOD 1       // poll for colour samples
+#define NAV_PERIOD 1          // advance the navigation state machine
+#define TELEMETRY_PERIOD 5    // send the latest sample
+#define LED_PERIOD 250        // status LED update
+
+void navInit(DATA *data, unsigned char isCalibrated);
+void sensorTask(void);
+void navTask(void);
+void telemetryTask(void);
+void ledTask(void);
+
+#endif
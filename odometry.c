@@ -0,0 +1,103 @@
+#include "hal.h"
+#include "dc_motor.h"
+#include "odometry.h"
+#include "structures.h"
+
+static ODOMETER odomL, odomR;   // left and right wheel odometers, advanced by the control tick
+
+/************************************************
+ *  Function to advance a wheel odometer by one control tick
+ *  The wheel speed lags the ramped motor power as a first order response,
+ *  so the distance includes spinning up, slowing down and coasting
+ ***********************************************/
+void odomUpdate(ODOMETER *o, DC_MOTOR *m) {
+    int target = m->power;                      // 8.8 power is already power x 256
+    if (!m->direction) {target = -target;}
+    
+    int step = ((long)target - o->speed) >> ODOM_LAG;  // long, a reversal from high power overflows an int
+    o->speed = step ? o->speed + step : target;     // settle exactly once within one step
+    o->count += (unsigned long)(long)o->speed;  // unsigned so the count wraps instead of overflowing
+}
+
+/************************************************
+ *  Function to run the odometry task, called from the timer interrupt after motorTask
+ ***********************************************/
+void odomTask(void) {
+    odomUpdate(&odomL, &motorL);
+    odomUpdate(&odomR, &motorR);
+}
+
+/************************************************
+ *  Function to stop both modelled wheels at once
+ *  Called once the buggy is pressed against a wall, where the wheels have
+ *  stalled although the motors are still driven, so no coast is counted
+ ***********************************************/
+void odomHalt(void) {
+    PIE5bits.TMR4IE = 0;            // the control tick updates the speeds
+    odomL.speed = 0;
+    odomR.speed = 0;
+    PIE5bits.TMR4IE = 1;
+}
+
+/************************************************
+ *  Function to return the distance travelled by the centre of the buggy
+ *  (the sum of both wheels, forward positive)
+ *  The counts are read again until they are unchanged, so an interrupt
+ *  mid-read can never return a torn value
+ ***********************************************/
+unsigned long odomRead(void) {
+    unsigned long l, r;
+    do {
+        l = odomL.count;
+        r = odomR.count;
+    } while (l != odomL.count || r != odomR.count);
+    return l + r;
+}
+
+/************************************************
+ *  Function to return the unsigned distance covered since a previous odomRead
+ *  in odometer counts of a single wheel
+ ***********************************************/
+long odomSince(unsigned long mark) {
+    long d = (long)(odomRead() - mark) / 2;
+    return d < 0 ? -d : d;
+}
+
+/************************************************
+ *  Function to return the distance the buggy will still coast once the motors stop
+ *  The modelled speed decays geometrically, so it covers speed x 2^ODOM_LAG more counts
+ ***********************************************/
+long odomStopping(void) {
+    int l, r;
+    do {
+        l = odomL.speed;
+        r = odomR.speed;
+    } while (l != odomL.speed || r != odomR.speed);
+    
+    long v = ((long)l + r) / 2;
+    return (v < 0 ? -v : v) << ODOM_LAG;
+}
+
+/************************************************
+ *  Function to check whether both wheels have come to rest
+ *  1: each wheel has less than one recorded step left to coast
+ *  0: still moving (including turning on the spot)
+ ***********************************************/
+unsigned char odomStill(void) {
+    int l, r;
+    do {
+        l = odomL.speed;
+        r = odomR.speed;
+    } while (l != odomL.speed || r != odomR.speed);
+    
+    long still = (1L << ODOM_SHIFT) >> ODOM_LAG;    // speed that coasts one step
+    return (l < 0 ? -(long)l : l) < still && (r < 0 ? -(long)r : r) < still;
+}
+
+/************************************************
+ *  Function to convert odometer counts to recorded distance steps (rounded)
+ ***********************************************/
+unsigned int odomSteps(long counts) {
+    unsigned long steps = ((unsigned long)counts + (1UL << (ODOM_SHIFT - 1))) >> ODOM_SHIFT;
+    return steps > 0xFFFF ? 0xFFFF : (unsigned int)steps;
+}
@@ -0,0 +1,21 @@
+#ifndef _odometry_H
+#define _odometry_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+#define ODOM_LAG 5          // wheel speed follows the motor power with a time constant of 2^ODOM_LAG ms
+#define ODOM_SHIFT 13       // odometer counts per recorded distance step (2^13 = 32 power x ms)
+
+void odomUpdate(ODOMETER *o, DC_MOTOR *m);
+void odomTask(void);
+void odomHalt(void);
+unsigned long odomRead(void);
+long odomSince(unsigned long mark);
+long odomStopping(void);
+unsigned char odomStill(void);
+unsigned int odomSteps(long counts);
+
+#endif
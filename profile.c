@@ -0,0 +1,101 @@
+#include "hal.h"
+#include "profile.h"
+#include "serial.h"
+#include "structures.h"
+#include "telemetry.h"
+
+#ifdef PROFILE_ENABLE
+
+static PROFILE profile[PROF_SECTIONS];        // statistics of each profiled section
+static volatile unsigned int profileHigh = 0;  // upper 16 bits of the cycle counter
+
+/************************************************
+ *  Function to set up timer 1 as a free running instruction cycle counter
+ *  Timer 1 counts Fosc/4 and its overflow interrupt extends it to 32 bits,
+ *  an overflow every 4.1ms and a range of 268s
+ ***********************************************/
+void profileInit(void) {
+    T1CLKbits.CS = 0b0001;    // Fosc/4, one count per instruction cycle
+    T1CONbits.CKPS = 0b00;    // 1:1 prescaler
+    T1CONbits.RD16 = 1;       // reading TMR1L latches TMR1H for an atomic 16 bit read
+    TMR1H = 0;
+    TMR1L = 0;
+    profileReset();
+    PIE5bits.TMR1IE = 1;      // count overflows into the upper 16 bits
+    T1CONbits.ON = 1;         // start the timer
+}
+
+/************************************************
+ *  Function to extend the cycle counter, called from the timer 1 interrupt
+ ***********************************************/
+void profileOverflow(void) {
+    profileHigh++;
+}
+
+/************************************************
+ *  Function to return the 32 bit cycle count
+ *  The timer is read again if the overflow interrupt ran in between. An
+ *  overflow that is still pending (inside an ISR) is added by hand once the
+ *  read is consistent, as the interrupt can not run to add it
+ ***********************************************/
+unsigned long profileNow(void) {
+    unsigned int high, low;
+    do {
+        high = profileHigh;
+        low = TMR1L;                          // latches TMR1H
+        low |= (unsigned int)TMR1H << 8;
+    } while (high != profileHigh);
+    if (PIR5bits.TMR1IF && low < 0x8000) {high++;}  // the timer wrapped after the pending overflow
+    return (unsigned long)high << 16 | low;
+}
+
+/************************************************
+ *  Function to add one run of a section to its statistics
+ ***********************************************/
+void profileRecord(unsigned char id, unsigned long cycles) {
+    PROFILE *p = &profile[id];
+    if (p->count == 0xFFFF) {return;}         // keep the mean valid once the count saturates
+    if (cycles < p->min) {p->min = cycles;}
+    if (cycles > p->max) {p->max = cycles;}
+    p->total += cycles;
+    p->count++;
+}
+
+/************************************************
+ *  Function to clear the statistics of every section
+ ***********************************************/
+void profileReset(void) {
+    for (unsigned char i = 0; i < PROF_SECTIONS; i++) {
+        profile[i].count = 0;
+        profile[i].min = 0xFFFFFFFF;
+        profile[i].max = 0;
+        profile[i].total = 0;
+    }
+}
+
+/************************************************
+ *  Function to send the statistics of every section over serial and clear them
+ *  Payload (little endian): section, count (2), min (4), max (4), total (4)
+ ***********************************************/
+void profileDump(void) {
+    for (unsigned char i = 0; i < PROF_SECTIONS; i++) {
+        unsigned char payload[TELEMETRY_PROFILE_LEN];
+        PROFILE p = profile[i];               // copy, the control tick may update PROF_SET_PWM
+        
+        payload[0] = i;
+        payload[1] = p.count & 0xFF;
+        payload[2] = p.count >> 8;
+        for (unsigned char b = 0; b < 4; b++) {
+            payload[3 + b] = p.min >> (8*b);
+            payload[7 + b] = p.max >> (8*b);
+            payload[11 + b] = p.total >> (8*b);
+        }
+        
+        // the dump is not on a hot path, so wait for room instead of dropping frames
+        while (TxBufSpace() < TELEMETRY_PROFILE_LEN + 5) {}
+        telemetrySend(TELEMETRY_PROFILE, payload, TELEMETRY_PROFILE_LEN);
+    }
+    profileReset();
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _profile_H
+#define _profile_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+// instrumentation is only built into debug images (MPLAB defines __DEBUG for them)
+#ifdef __DEBUG
+#define PROFILE_ENABLE
+#endif
+
+// profiled sections
+#define PROF_SAMPLE 0         // handling of a new background colour sample
+#define PROF_RGB2HSV 1        // RGB to HSV conversion
+#define PROF_CLASSIFY 2       // nearest colour match
+#define PROF_DETECT 3         // classify and vote on one card sample
+#define PROF_SET_PWM 4        // motor PWM update (runs in the control tick)
+#define PROF_APPROACH 5       // one wall approach step that processed a sample
+#define PROF_SECTIONS 6       // number of profiled sections
+
+#ifdef PROFILE_ENABLE
+
+// time a section in instruction cycles, START and END must be in the same block
+#define PROF_START(id) unsigned long prof_start_##id = profileNow()
+#define PROF_END(id) profileRecord(id, profileNow() - prof_start_##id)
+
+void profileInit(void);
+void profileOverflow(void);
+unsigned long profileNow(void);
+void profileRecord(unsigned char id, unsigned long cycles);
+void profileReset(void);
+void profileDump(void);
+
+#else
+
+// release builds compile the instrumentation out entirely
+#define PROF_START(id)
+#define PROF_END(id)
+#define profileInit()
+#define profileDump()
+
+#endif
+
+#endif
@@ -1,24 +1,26 @@
 import serial
 import numpy as np
+from telemetry import BAUD, decode
 
 
-serialPort = serial.Serial(port="COM10", baudrate=19200, parity=serial.PARITY_NONE,
-                           bytesize=serial.EIGHTBITS, timeout=3, stopbits=serial.STOPBITS_ONE)
-
+serialPort = serial.Serial(port="COM10", baudrate=BAUD, parity=serial.PARITY_NONE,
+                           bytesize=serial.EIGHTBITS, timeout=0.1, stopbits=serial.STOPBITS_ONE)
 
+buf = bytearray()
 while 1:
-    color_str = serialPort.readline().decode('ascii')
-    color_str = color_str.strip('\n')
+    # decode every complete frame received so far
+    buf += serialPort.read(max(1, serialPort.in_waiting))
+    samples, consumed, bad = decode(buf)
+    del buf[:consumed]
+    if len(samples) == 0:
+        continue
 
-    # Convert to RGB 255 value
-    color = np.array(list(map(int, color_str.split(',')))[1:])
-    color[0] = color[0] / 2770 * 255
-    color[1] = color[1] / 2060 * 255
-    color[2] = color[2] / 1410 * 255
+    # Convert the whole batch to RGB 255 values
+    color = np.stack([samples['r'] / 2770, samples['g'] / 2060, samples['b'] / 1410], axis=1) * 255
 
     # 7200, 3500, 2600, 1800
     # 17100, 7800, 6100, 4400
 
     # 2770, 2060, 1410
 
-    print(color)
+    print(color.astype(int)[-1])
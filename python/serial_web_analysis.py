@@ -1,12 +1,13 @@
 import serial
 import numpy as np
 import time
+from telemetry import BAUD, decode
 from selenium import webdriver
 from selenium.webdriver.common.keys import Keys
 
 
-serialPort = serial.Serial(port="COM10", baudrate=19200, parity=serial.PARITY_NONE,
-                           bytesize=serial.EIGHTBITS, timeout=3, stopbits=serial.STOPBITS_ONE)
+serialPort = serial.Serial(port="COM10", baudrate=BAUD, parity=serial.PARITY_NONE,
+                           bytesize=serial.EIGHTBITS, timeout=0.1, stopbits=serial.STOPBITS_ONE)
 
 driver = webdriver.Chrome('C:\\Python\\Selenium\\chromedriver.exe')
 driver.implicitly_wait(15)
@@ -14,15 +15,18 @@ driver.get('https://tuneform.com/tools/color/rgb-color-creator')
 
 time.sleep(10)
 
+buf = bytearray()
 while 1:
-    color_str = serialPort.readline().decode('ascii')
-    color_str = color_str.strip('\n')
+    # decode every frame received while the browser was updating, only the latest is shown
+    buf += serialPort.read(max(1, serialPort.in_waiting))
+    samples, consumed, bad = decode(buf)
+    del buf[:consumed]
+    if len(samples) == 0:
+        continue
+    latest = samples[-1]
 
     # Convert to RGB 255 value
-    color = np.array(list(map(int, color_str.split(',')))[1:])
-    color[0] = color[0] / 2770 * 255
-    color[1] = color[1] / 2060 * 255
-    color[2] = color[2] / 1410 * 255
+    color = np.array([latest['r'] / 2770, latest['g'] / 2060, latest['b'] / 1410]) * 255
 
     # 7200, 3500, 2600, 1800
     # 17100, 7800, 6100, 4400
@@ -0,0 +1,248 @@
+"""Decoder and analysis tools for the buggy's binary telemetry stream.
+
+Colour samples are logged, profile dumps (debug firmware, hold both
+buttons) are printed as a table.
+
+Frame layout (see telemetry.c):
+    0xAA 0x55 | type | length | payload | checksum
+The bytes from type to checksum sum to zero (mod 256).
+
+Usage:
+    python telemetry.py live COM10 run.bin       # decode the serial port into a log
+    python telemetry.py decode capture.raw run.bin  # decode a raw byte capture
+    python telemetry.py replay run.bin           # summary and plots of a log
+"""
+import os
+import re
+import sys
+import numpy as np
+
+SYNC = b'\xaa\x55'
+SAMPLE = 0x01
+PROFILE = 0x02
+NO_CLASS = 0xFF
+BAUD = 115200
+CYCLE_NS = 62.5     # instruction cycle at 64MHz
+
+COLORS = ['red', 'green', 'blue', 'yellow', 'pink', 'orange', 'light blue', 'white', 'black']
+PROFILE_H = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'profile.h')
+
+
+def load_sections(path=PROFILE_H):
+    """Name the profiled sections from the PROF_* ids in profile.h.
+
+    The names follow the ids (PROF_SET_PWM is 'set pwm'), so a section added
+    to the firmware is labelled without editing this file. Falls back to the
+    ids as they were last copied here if profile.h is not next to the tools.
+    """
+    try:
+        with open(path) as f:
+            ids = re.findall(r'^#define PROF_(\w+) (\d+)', f.read(), re.M)
+    except OSError:
+        return ['sample', 'rgb2hsv', 'classify', 'detect', 'set pwm', 'approach']
+    names = {int(n): name.lower().replace('_', ' ') for name, n in ids if name != 'SECTIONS'}
+    return [names.get(i, str(i)) for i in range(max(names) + 1)] if names else []
+
+
+SECTIONS = load_sections()
+
+# colour sample payload, little endian and packed to match telemetry.c
+SAMPLE_DTYPE = np.dtype([
+    ('seq', 'u1'), ('time', '<u4'),
+    ('r', '<u2'), ('g', '<u2'), ('b', '<u2'), ('c', '<u2'),
+    ('h', '<u2'), ('s', '<u2'), ('v', '<u2'),
+    ('cls', 'u1'), ('margin', '<u2'),
+    ('powerL', 'u1'), ('powerR', 'u1'), ('dirs', 'u1'),
+    ('dropped', '<u2'),
+])
+
+# profiled section payload, see profile.c
+PROFILE_DTYPE = np.dtype([
+    ('section', 'u1'), ('count', '<u2'), ('min', '<u4'), ('max', '<u4'), ('total', '<u4'),
+])
+
+FORMATS = {SAMPLE: SAMPLE_DTYPE, PROFILE: PROFILE_DTYPE}
+
+
+def decode_frames(buf):
+    """Decode every valid frame in a byte buffer.
+
+    Candidate frames are found and checked with vectorised numpy operations,
+    so corrupt or partial frames are skipped and decoding resyncs on the next
+    valid header. Returns (frames, consumed, bad) where frames maps each frame
+    type to its records, consumed is the number of leading bytes that no longer
+    need to be kept and bad is the number of headers that failed the checksum.
+    """
+    data = np.frombuffer(bytes(buf), dtype=np.uint8)
+    frames = {t: np.zeros(0, dtype=d) for t, d in FORMATS.items()}
+    n = len(data)
+    if n < 4:
+        return frames, 0, 0
+
+    # headers of a known type and length
+    start = np.flatnonzero((data[:n - 3] == 0xAA) & (data[1:n - 2] == 0x55))
+    known = np.zeros(len(start), dtype=bool)
+    for t, d in FORMATS.items():
+        known |= (data[start + 2] == t) & (data[start + 3] == d.itemsize)
+    start = start[known]
+    end = start + data[start + 3].astype(np.int64) + 5
+
+    # frames still arriving are left in the buffer
+    complete = end <= n
+    pending = start[~complete]
+    start, end = start[complete], end[complete]
+
+    # checksum of each candidate from the prefix sums
+    csum = np.concatenate(([0], np.cumsum(data, dtype=np.uint32)))
+    ok = (csum[end] - csum[start + 2]) % 256 == 0
+    bad = int(np.count_nonzero(~ok))
+    start, end = start[ok], end[ok]
+
+    # a valid frame can contain a false header, keep frames that do not overlap
+    keep = np.ones(len(start), dtype=bool)
+    last = 0
+    for i in range(len(start)):
+        if start[i] < last:
+            keep[i] = False
+        else:
+            last = end[i]
+    start = start[keep]
+
+    for t, d in FORMATS.items():
+        s = start[data[start + 2] == t]
+        if len(s):
+            payload = data[s[:, None] + 4 + np.arange(d.itemsize)]
+            frames[t] = np.ascontiguousarray(payload).view(d).reshape(-1)
+
+    # keep the last 3 bytes (a header can not be checked yet) and any pending frame
+    pending = pending[pending >= last]
+    consumed = max(last, min(pending.min() if len(pending) else n, n - 3))
+    return frames, int(consumed), bad
+
+
+def decode(buf):
+    """Decode the colour sample frames in a byte buffer, see decode_frames."""
+    frames, consumed, bad = decode_frames(buf)
+    return frames[SAMPLE], consumed, bad
+
+
+def print_profile(p):
+    """Print a table of profiled sections."""
+    print('%-16s %7s %12s %12s %12s' % ('section', 'count', 'min (us)', 'mean (us)', 'max (us)'))
+    for r in p:
+        name = SECTIONS[r['section']] if r['section'] < len(SECTIONS) else str(r['section'])
+        if r['count'] == 0:
+            print('%-16s %7d %12s %12s %12s' % (name, 0, '-', '-', '-'))
+            continue
+        us = CYCLE_NS / 1000
+        print('%-16s %7d %12.1f %12.1f %12.1f' % (name, r['count'], r['min'] * us,
+                                                  r['total'] / r['count'] * us, r['max'] * us))
+
+
+def decode_file(raw_path, log_path):
+    """Decode a raw byte capture into a sample log and print any profile dump."""
+    with open(raw_path, 'rb') as f:
+        frames, _, bad = decode_frames(f.read())
+    with open(log_path, 'wb') as f:
+        frames[SAMPLE].tofile(f)
+    print('%d samples, %d bad frames' % (len(frames[SAMPLE]), bad))
+    if len(frames[PROFILE]):
+        print_profile(frames[PROFILE])
+
+
+def live(port, log_path):
+    """Decode the serial port into a sample log until interrupted."""
+    import serial
+
+    serialPort = serial.Serial(port=port, baudrate=BAUD, parity=serial.PARITY_NONE,
+                               bytesize=serial.EIGHTBITS, timeout=0.1, stopbits=serial.STOPBITS_ONE)
+    buf = bytearray()
+    total = bad = 0
+    with open(log_path, 'ab') as log:
+        try:
+            while 1:
+                buf += serialPort.read(max(1, serialPort.in_waiting))
+                frames, consumed, n = decode_frames(buf)
+                del buf[:consumed]
+                bad += n
+                if len(frames[PROFILE]):
+                    print()
+                    print_profile(frames[PROFILE])
+                samples = frames[SAMPLE]
+                if len(samples):
+                    samples.tofile(log)
+                    log.flush()
+                    total += len(samples)
+                    last = samples[-1]
+                    print('%8d samples  %4d bad  dropped %5d  t=%9d ms  rgbc=%5d %5d %5d %5d  class=%s'
+                          % (total, bad, last['dropped'], last['time'], last['r'], last['g'], last['b'],
+                             last['c'], class_name(last['cls'])), end='\r')
+        except KeyboardInterrupt:
+            print()
+
+
+def load(log_path):
+    """Open a sample log as a memory mapped structured array."""
+    return np.memmap(log_path, dtype=SAMPLE_DTYPE, mode='r')
+
+
+def class_name(cls):
+    return COLORS[cls] if cls < len(COLORS) else '-'
+
+
+def replay(log_path, plot=True):
+    """Print a summary of a sample log and plot the margins and loop timing."""
+    s = load(log_path)
+    if len(s) == 0:
+        print('empty log')
+        return
+
+    dt = np.diff(s['time'].astype(np.int64))
+    lost = np.count_nonzero(np.diff(s['seq'].astype(np.int16)) % 256 > 1)
+    print('samples      %d over %.1f s' % (len(s), (int(s['time'][-1]) - int(s['time'][0])) / 1000))
+    print('dropped      %d frames on the buggy, %d gaps in the sample sequence' % (s['dropped'][-1], lost))
+    if len(dt):
+        print('sample gap   median %.1f ms, p95 %.1f ms, max %d ms'
+              % (np.median(dt), np.percentile(dt, 95), dt.max()))
+
+    classified = s[s['cls'] != NO_CLASS]
+    for cls in np.unique(classified['cls']):
+        m = classified['margin'][classified['cls'] == cls]
+        print('%-12s %4d samples, margin median %6d, min %6d' % (class_name(cls), len(m), np.median(m), m.min()))
+
+    if not plot:
+        return
+    import matplotlib.pyplot as plt
+
+    fig, ax = plt.subplots(1, 3, figsize=(15, 4))
+    t = (s['time'] - s['time'][0]) / 1000
+    ax[0].plot(t, s['c'], label='clear')
+    ax[0].plot(t, s['powerL'], label='left power')
+    ax[0].set_xlabel('time (s)')
+    ax[0].legend()
+    ax[0].set_title('clear channel and motor power')
+
+    if len(dt):
+        ax[1].hist(dt, bins=50)
+    ax[1].set_xlabel('sample gap (ms)')
+    ax[1].set_title('loop timing')
+
+    for cls in np.unique(classified['cls']):
+        ax[2].hist(classified['margin'][classified['cls'] == cls], bins=30, alpha=0.6, label=class_name(cls))
+    ax[2].set_xlabel('margin')
+    ax[2].legend()
+    ax[2].set_title('classification margins')
+
+    plt.tight_layout()
+    plt.show()
+
+
+if __name__ == '__main__':
+    if len(sys.argv) == 4 and sys.argv[1] == 'live':
+        live(sys.argv[2], sys.argv[3])
+    elif len(sys.argv) == 4 and sys.argv[1] == 'decode':
+        decode_file(sys.argv[2], sys.argv[3])
+    elif len(sys.argv) == 3 and sys.argv[1] == 'replay':
+        replay(sys.argv[2])
+    else:
+        print(__doc__)
@@ -0,0 +1,40 @@
+#include "hal.h"
+#include "scheduler.h"
+#include "structures.h"
+#include "timers.h"
+
+static TASK tasks[SCHEDULER_TASKS];     // periodic tasks in the order they are run
+static unsigned char taskCount = 0;     // number of tasks added
+
+/************************************************
+ *  Function to add a periodic task to the scheduler
+ *  Tasks run in the order they were added, so a task that consumes the
+ *  output of another should be added after it
+ *  1: task added
+ *  0: task table full
+ ***********************************************/
+unsigned char schedulerAdd(void (*run)(void), unsigned int period) {
+    if (taskCount >= SCHEDULER_TASKS) {return 0;}
+    
+    tasks[taskCount].run = run;
+    tasks[taskCount].period = period;
+    tasks[taskCount].next = getTicks();     // run on the first pass
+    taskCount++;
+    return 1;
+}
+
+/************************************************
+ *  Function to run every task whose period has elapsed, called from the main loop
+ *  A task that fell more than a period behind (after a blocking menu) is
+ *  rescheduled from now rather than run repeatedly to catch up
+ ***********************************************/
+void schedulerRun(void) {
+    for (unsigned char i = 0; i < taskCount; i++) {
+        TASK *t = &tasks[i];
+        if (!deadlineReached(t->next)) {continue;}
+        
+        t->next += t->period;
+        if (deadlineReached(t->next)) {t->next = getTicks() + t->period;}
+        t->run();
+    }
+}
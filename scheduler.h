@@ -0,0 +1,14 @@
+#ifndef _scheduler_H
+#define _scheduler_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+#define SCHEDULER_TASKS 8   // maximum number of periodic tasks
+
+unsigned char schedulerAdd(void (*run)(void), unsigned int period);
+void schedulerRun(void);
+
+#endif
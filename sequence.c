@@ -1,19 +1,126 @@
-#include <xc.h>
+#include "hal.h"
 #include "dc_motor.h"
 #include "hardware.h"
+#include "map.h"
+#include "odometry.h"
 #include "sequence.h"
 #include "structures.h"
 #include "timers.h"
 
 /***********************************************
  *  Function to add move to moves to data structure
+ *  The move is packed into a single code byte and its distance, power is stored
+ *  in steps of 2 and angles in steps of 45 degrees. Once fewer than
+ *  SEQUENCE_RESERVE moves are left the backtrack flag is raised, so the buggy
+ *  heads home while its full path still fits. The move also updates the map,
+ *  even once the sequence is full. Returns 0 if the move was lost
  ***********************************************/
-void addMove(DATA *data, unsigned char type, unsigned char direction, unsigned char power, unsigned int time) {
-    data->sequence->moves[data->sequence->index].type = type;            // add type data to sequence
-    data->sequence->moves[data->sequence->index].direction = direction;  // add direction data to sequence
-    data->sequence->moves[data->sequence->index].power = power;          // add power data to sequence
-    data->sequence->moves[data->sequence->index].time = time;            // add time data to sequence
-    data->sequence->index++;                                             // increment index counter
+unsigned char addMove(DATA *data, unsigned char type, unsigned char direction, unsigned char power, unsigned int distance) {
+    SEQUENCE *seq = data->sequence;
+    MOVE move;
+    move.code = (type ? MOVE_ROTATE | (unsigned char)(power / 45) : (unsigned char)(power >> 1)) & (MOVE_ROTATE | MOVE_ARG);
+    if (direction) {move.code |= MOVE_DIR;}             // add direction bit to the code
+    move.distance = distance;                           // add distance data to the move
+    mapMove(data->map, &move);                          // track the position on the map
+    
+    if (seq->index >= SEQUENCE_MAX) {                   // sequence full, nothing more can be remembered
+        data->backtrack = 1;
+        return 0;
+    }
+    seq->moves[seq->index] = move;                      // add move to sequence
+    seq->index++;                                       // increment index counter
+    
+    // return home before the sequence runs out of room
+    if (seq->index > SEQUENCE_MAX - SEQUENCE_RESERVE) {data->backtrack = 1;}
+    return 1;
+}
+
+/***********************************************
+ *  Function to give the signed distance of a straight move, forward is positive
+ ***********************************************/
+static long moveDistance(MOVE *m) {
+    return moveDirection(m) ? (long)m->distance : -(long)m->distance;
+}
+
+/***********************************************
+ *  Function to give the signed angle of a rotate move, right is positive
+ ***********************************************/
+static int moveAngle(MOVE *m) {
+    return moveDirection(m) ? movePower(m) : -movePower(m);
+}
+
+/***********************************************
+ *  Function to set a straight move to cover a signed distance at its own power
+ *  Returns 0 and leaves the move untouched if the distance does not fit in 16 bits
+ ***********************************************/
+static unsigned char setDistance(MOVE *m, long d) {
+    unsigned long t = (unsigned long)(d < 0 ? -d : d);
+    if (t > 0xFFFF) {return 0;}
+    
+    if (d < 0) {m->code &= ~MOVE_DIR;}
+    else {m->code |= MOVE_DIR;}
+    m->distance = (unsigned int)t;
+    return 1;
+}
+
+/***********************************************
+ *  Function to remove n moves from the sequence starting at index i
+ ***********************************************/
+static void removeMoves(SEQUENCE *seq, unsigned char i, unsigned char n) {
+    for (; i + n < seq->index; i++) {seq->moves[i] = seq->moves[i + n];}
+    seq->index -= n;
+}
+
+/***********************************************
+ *  Function to shorten the sequence before it is replayed
+ *  Repeats three rewrites until none apply:
+ *   - neighbouring straights merge into one with the net distance
+ *   - neighbouring rotations fold into one (or none if they cancel)
+ *   - straight, 180 deg, straight becomes 180 deg, straight, which lets a
+ *     dead end undone by a blue card collapse into the turn that avoids it
+ ***********************************************/
+void optimisePath(SEQUENCE *seq) {
+    unsigned char changed = 1;
+    while (changed) {
+        changed = 0;
+        for (unsigned char i = 0; i + 1 < seq->index; i++) {
+            MOVE *a = &seq->moves[i];
+            MOVE *b = a + 1;
+            
+            // merge straights, the back away from each wall cancels part of the approach
+            if (!moveType(a) && !moveType(b) && movePower(a) > 0) {
+                if (setDistance(a, moveDistance(a) + moveDistance(b))) {
+                    if (a->distance) {removeMoves(seq, i + 1, 1);}
+                    else {removeMoves(seq, i, 2);}      // the straights cancelled out
+                    changed = 1;
+                }
+            }
+            
+            // fold rotations into a single turn of at most 180 deg
+            else if (moveType(a) && moveType(b)) {
+                int angle = (moveAngle(a) + moveAngle(b) + 720) % 360;
+                if (angle == 0) {removeMoves(seq, i, 2);}
+                else {
+                    a->code = MOVE_ROTATE | (angle <= 180 ? MOVE_DIR | (angle / 45) : (360 - angle) / 45);
+                    removeMoves(seq, i + 1, 1);
+                }
+                changed = 1;
+            }
+            
+            // move a 180 deg turn ahead of the straight before it
+            else if (!moveType(a) && moveType(b) && movePower(b) == 180 && i + 2 < seq->index && !moveType(b + 1)) {
+                MOVE turn = *b;
+                MOVE after = *(b + 1);
+                if (movePower(&after) > 0 && setDistance(&after, moveDistance(b + 1) - moveDistance(a))) {
+                    *a = turn;
+                    *b = after;
+                    if (after.distance) {removeMoves(seq, i + 2, 1);}
+                    else {removeMoves(seq, i + 1, 2);}  // the buggy came straight back
+                    changed = 1;
+                }
+            }
+        }
+    }
 }
 
 /***********************************************
@@ -24,23 +131,29 @@ void backtrack(DATA *data) {
     INDICATOR_L = 1;
     INDICATOR_R = 1;
     
+    mapPlanHome(data);              // take the shortest known path if it beats retracing the exploration
+    optimisePath(data->sequence);   // drop moves that cancel out before replaying them
+    
     // iterate back through the sorted movements
-    for (unsigned int i = data->sequence->index; i > 0; i--) {
+    for (unsigned char i = data->sequence->index; i > 0; i--) {
+        MOVE *m = &data->sequence->moves[i-1];
+        
         // turn movements
-        if ((data->sequence->moves[i-1].type)) {
-            rotate(!data->sequence->moves[i-1].direction, data->sequence->moves[i-1].power);
+        if (moveType(m)) {
+            rotate(!moveDirection(m), movePower(m));
         }
         
         // traverse movements
         else {
-            resetTimer();
-            straight(!data->sequence->moves[i-1].direction, data->sequence->moves[i-1].power);
-            // keep moving while the timer is less than the time taken by the move
-            while (get16bitTMR0val() <= data->sequence->moves[i-1].time) {}
+            long target = (long)m->distance << ODOM_SHIFT;
+            unsigned long mark = odomRead();
+            straight(!moveDirection(m), movePower(m));
+            // keep moving until coasting to a stop will cover the rest of the move
+            while (odomSince(mark) + odomStopping() < target) {}
             stop();
         }
         
-        __delay_ms(500);        // delay set after each backtrack move
+        while (!motorsSettled() || !odomStill()) {}    // come to rest before the next move
     }
     
     // turn off the indicators once all moves have been executed
@@ -1,12 +1,24 @@
 #ifndef _sequence_H
 #define _sequence_H
 
-#include <xc.h>
+#include "hal.h"
 #include "structures.h"
 
 #define _XTAL_FREQ 64000000
 
-void addMove(DATA *data, unsigned char type, unsigned char direction, unsigned char power, unsigned int time);
+#define SEQUENCE_RESERVE 4    // free moves kept so the color action in progress can always be recorded
+
+// packing of the MOVE code byte
+#define MOVE_ROTATE 0x80      // set for rotate moves, clear for straight moves
+#define MOVE_DIR 0x40         // set for forward/right, clear for backward/left
+#define MOVE_ARG 0x3F         // quantised power (steps of 2) or angle (steps of 45 degrees)
+
+#define moveType(m) (((m)->code & MOVE_ROTATE) != 0)
+#define moveDirection(m) (((m)->code & MOVE_DIR) != 0)
+#define movePower(m) (moveType(m) ? ((m)->code & MOVE_ARG) * 45 : ((m)->code & MOVE_ARG) << 1)
+
+unsigned char addMove(DATA *data, unsigned char type, unsigned char direction, unsigned char power, unsigned int distance);
+void optimisePath(SEQUENCE *seq);
 void backtrack(DATA *data);
 
 #endif
@@ -1,6 +1,18 @@
-#include <xc.h>
+#include "hal.h"
 #include "serial.h"
 
+//variables for a software RX/TX buffer
+static volatile char EUSART4RXbuf[RX_BUF_SIZE];
+static volatile unsigned char RxBufWriteCnt=0;
+static volatile unsigned char RxBufReadCnt=0;
+
+static volatile char EUSART4TXbuf[TX_BUF_SIZE];
+static volatile unsigned char TxBufWriteCnt=0;
+static volatile unsigned char TxBufReadCnt=0;
+
+volatile unsigned int RxBufOverflow=0;
+unsigned int TxBufDropped=0;
+
 /************************************************
  *  Function to initialise USART
  ***********************************************/
@@ -11,10 +23,10 @@ void initUSART4(void) {
     
     TRISCbits.TRISC1 = 1;     // set TRIS value for RC1 pin
 
-    BAUD4CONbits.BRG16 = 0;   // set baud rate scaling
-    TX4STAbits.BRGH = 0;   	  // high baud rate select bit
-    SP4BRGL = 51; 			  // set baud rate to 51 = 19200 bps
-    SP4BRGH = 0;		      // not used
+    BAUD4CONbits.BRG16 = 1;   // 16 bit baud rate generator
+    TX4STAbits.BRGH = 1;   	  // high baud rate select bit
+    SP4BRGL = SERIAL_BRG & 0xFF;  // set baud rate to 115200 bps
+    SP4BRGH = SERIAL_BRG >> 8;
 
     RC4STAbits.CREN = 1; 	  // enable continuous reception
     TX4STAbits.TXEN = 1; 	  // enable transmitter
@@ -52,16 +64,20 @@ void sendStringSerial4(char *string){
  *  Retrieve a byte from the buffer
  ***********************************************/
 char getCharFromRxBuf(void){
-    if (RxBufReadCnt>=RX_BUF_SIZE) {RxBufReadCnt=0;} 
-    return EUSART4RXbuf[RxBufReadCnt++];
+    char byte = EUSART4RXbuf[RxBufReadCnt];
+    RxBufReadCnt = RxBufReadCnt+1 >= RX_BUF_SIZE ? 0 : RxBufReadCnt+1;
+    return byte;
 }
 
 /************************************************
  *  Function to add a byte to the Rx buffer
+ *  The byte is counted and dropped if the buffer is full
  ***********************************************/
 void putCharToRxBuf(char byte){
-    if (RxBufWriteCnt>=RX_BUF_SIZE) {RxBufWriteCnt=0;}
-    EUSART4RXbuf[RxBufWriteCnt++]=byte;
+    unsigned char next = RxBufWriteCnt+1 >= RX_BUF_SIZE ? 0 : RxBufWriteCnt+1;
+    if (next == RxBufReadCnt) {RxBufOverflow++; return;}
+    EUSART4RXbuf[RxBufWriteCnt]=byte;
+    RxBufWriteCnt=next;
 }
 
 /************************************************
@@ -78,20 +94,24 @@ char isDataInRxBuf (void){
  *  Retrieve a byte from the buffer
  ***********************************************/
 char getCharFromTxBuf(void){
-    if (TxBufReadCnt>=TX_BUF_SIZE) {TxBufReadCnt=0;} 
-    return EUSART4TXbuf[TxBufReadCnt++];
+    char byte = EUSART4TXbuf[TxBufReadCnt];
+    TxBufReadCnt = TxBufReadCnt+1 >= TX_BUF_SIZE ? 0 : TxBufReadCnt+1;
+    return byte;
 }
 
 /************************************************
  *  Function to add a byte to the Tx buffer
+ *  Callers must check TxBufSpace first, a full buffer drops the byte
  ***********************************************/
 void putCharToTxBuf(char byte){
-    if (TxBufWriteCnt>=TX_BUF_SIZE) {TxBufWriteCnt=0;}
-    EUSART4TXbuf[TxBufWriteCnt++]=byte;
+    unsigned char next = TxBufWriteCnt+1 >= TX_BUF_SIZE ? 0 : TxBufWriteCnt+1;
+    if (next == TxBufReadCnt) {return;}
+    EUSART4TXbuf[TxBufWriteCnt]=byte;
+    TxBufWriteCnt=next;
 }
 
 /************************************************
- *  Function to check if there is data in the RX buffer
+ *  Function to check if there is data in the TX buffer
  *  1: there is data in the buffer
  *  0: nothing in the buffer
  ***********************************************/
@@ -99,6 +119,14 @@ char isDataInTxBuf (void){
     return (TxBufWriteCnt!=TxBufReadCnt);
 }
 
+/************************************************
+ *  Function to return the number of free bytes in the Tx buffer
+ ***********************************************/
+unsigned char TxBufSpace(void){
+    unsigned char read = TxBufReadCnt;  // read once, the ISR may advance it
+    return (read > TxBufWriteCnt ? 0 : TX_BUF_SIZE) + read - TxBufWriteCnt - 1;
+}
+
 /************************************************
  *  Function to add a string to the Tx buffer
  ***********************************************/
@@ -109,6 +137,22 @@ void TxBufferedString(char *string){
     }
 }
 
+/************************************************
+ *  Function to add a block of bytes to the Tx buffer without waiting
+ *  The whole block is dropped and counted if it does not fit, so a
+ *  receiver never sees a partial frame
+ *  1: block buffered
+ *  0: block dropped
+ ***********************************************/
+unsigned char TxBufferedBytes(unsigned char *bytes, unsigned char length){
+    if (TxBufSpace() < length) {
+        TxBufDropped++;
+        return 0;
+    }
+    while (length--) {putCharToTxBuf(*bytes++);}
+    return 1;
+}
+
 /************************************************
  *  Initialise interrupt driven transmission of the Tx buf
  ***********************************************/
@@ -1,21 +1,18 @@
 #ifndef _SERIAL_H
 #define _SERIAL_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define _XTAL_FREQ 64000000 //note intrinsic _delay function is 62.5ns at 64,000,000Hz  
 
 #define RX_BUF_SIZE 20
-#define TX_BUF_SIZE 60
+#define TX_BUF_SIZE 128
 
-//variables for a software RX/TX buffer
-volatile char EUSART4RXbuf[RX_BUF_SIZE];
-volatile char RxBufWriteCnt=0;
-volatile char RxBufReadCnt=0;
+#define SERIAL_BRG 138      // 16 bit BRG with BRGH: 64MHz / (4 * (138 + 1)) = 115108 bps (0.08% from 115200)
 
-volatile char EUSART4TXbuf[TX_BUF_SIZE];
-volatile char TxBufWriteCnt=0;
-volatile char TxBufReadCnt=0;
+//counters of data lost to full buffers
+extern volatile unsigned int RxBufOverflow;    // bytes received while the RX buffer was full
+extern unsigned int TxBufDropped;              // frames dropped while the TX buffer was too full
 
 //basic EUSART funcitons
 void initUSART4(void);
@@ -32,7 +29,9 @@ char isDataInRxBuf (void);
 char getCharFromTxBuf(void);
 void putCharToTxBuf(char byte);
 char isDataInTxBuf (void);
+unsigned char TxBufSpace(void);
 void TxBufferedString(char *string);
+unsigned char TxBufferedBytes(unsigned char *bytes, unsigned char length);
 void sendTxBuf(void);
 
 #endif
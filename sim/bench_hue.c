@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "hal.h"
+#include "color.h"
+#include "structures.h"
+
+/************************************************
+ *  Host benchmark of the hue kernel in rgb2hsv()
+ *  Sweeps the RGB space at several full scale ranges and reports the hue
+ *  error of the reciprocal table kernel, the original division with XC8's
+ *  16 bit int, and the same division done without overflow, each against a
+ *  floating point reference. Hue is in tenths of a degree (0 - 3599).
+ *  PIC18 cycles are estimated from a per operation cost model, as the host
+ *  can not time the target; PROF_RGB2HSV measures them on the buggy
+ ***********************************************/
+
+#define GRID 128                    // sweep levels per channel
+#define RANDOM 2000000              // random triples per full scale range
+#define TIMING_SAMPLES 4096         // triples in the host timing loop
+#define TIMING_PASSES 500
+
+// estimated PIC18 instruction cycles for each operation (XC8, 8x8 hardware multiplier)
+#define CYC_COMMON 60               // min/max search, branches and the sector offset
+#define CYC_MUL16 28                // 16 x 16 -> 16 bit multiply
+#define CYC_DIV16 240               // 16 / 16 bit unsigned division library call
+#define CYC_MOD16 230               // 16 % 16 bit unsigned remainder library call
+#define CYC_NORM_STEP 10            // one shift of num and diff with the loop test
+#define CYC_TABLE 14                // 16 bit program memory table read
+#define CYC_MUL32 50                // 16 x 16 -> 32 bit multiply
+#define CYC_ROUND 30                // 32 bit add and shift right by 13
+#define CYC_REMAINDER 90            // 16 x 16 -> 32 bit multiply, 600 * num and the 32 bit subtract
+#define CYC_CORRECT 20              // one correction step of the quotient and the 32 bit remainder
+
+static const unsigned int scales[] = {255, 1023, 4095, 16383, 65535};
+
+/************************************************
+ *  Function to return the exact hue of an RGB triple
+ ***********************************************/
+static double hueReference(RGB rgb) {
+    double r = rgb.r, g = rgb.g, b = rgb.b;
+    double max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    double min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    double diff = max - min, h;
+    if (diff == 0) {return 0;}
+    if (r == max) {h = 600 * (g - b) / diff;}
+    else if (g == max) {h = 1200 + 600 * (b - r) / diff;}
+    else {h = 2400 + 600 * (r - g) / diff;}
+    return h < 0 ? h + 3600 : h;
+}
+
+/************************************************
+ *  Function to return the hue of the original rgb2hsv, with 16 bit int as on XC8
+ ***********************************************/
+static unsigned int hueOld(RGB rgb) {
+    uint16_t r = rgb.r, g = rgb.g, b = rgb.b;
+    uint16_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    uint16_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    uint16_t diff = max - min;
+    if (!diff) {return 0;}
+    if (r == max) {return (uint16_t)(3600 + (uint16_t)((uint16_t)(600 * (uint16_t)(g - b)) / diff)) % 3600;}
+    if (g == max) {return (uint16_t)(1200 + (uint16_t)((uint16_t)(600 * (uint16_t)(b - r)) / diff)) % 3600;}
+    return (uint16_t)(2400 + (uint16_t)((uint16_t)(600 * (uint16_t)(r - g)) / diff)) % 3600;
+}
+
+/************************************************
+ *  Function to return the hue of the original formula without overflow
+ *  (signed 32 bit, truncating division as C does)
+ ***********************************************/
+static unsigned int hueDivide(RGB rgb) {
+    long r = rgb.r, g = rgb.g, b = rgb.b;
+    long max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    long min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    long diff = max - min;
+    if (!diff) {return 0;}
+    if (r == max) {return (3600 + 600 * (g - b) / diff) % 3600;}
+    if (g == max) {return (1200 + 600 * (b - r) / diff) % 3600;}
+    return (2400 + 600 * (r - g) / diff) % 3600;
+}
+
+/************************************************
+ *  Function to estimate the PIC18 cycles of the hue of each kernel
+ ***********************************************/
+static unsigned int cyclesOld(RGB rgb) {
+    return CYC_COMMON + CYC_MUL16 + CYC_DIV16 + CYC_MOD16;
+}
+
+/************************************************
+ *  Function to count the correction steps hueRatio takes from its table estimate
+ ***********************************************/
+static unsigned int corrections(unsigned int num, unsigned int diff) {
+    unsigned int d = diff, shift = 13, steps = 0;
+    unsigned long n = num;
+    while (d > 255) {d >>= 1; shift++;}
+    while (d < 128) {d <<= 1; n <<= 1;}
+    long q = (long)((n * (unsigned long)(600.0 * 8192 / d + 0.5)) >> shift);
+    long exact = (600L * num + diff / 2) / diff;
+    for (; q != exact; q += q < exact ? 1 : -1) {steps++;}
+    return steps;
+}
+
+static unsigned int cyclesTable(RGB rgb) {
+    unsigned int max = rgb.r > rgb.g ? (rgb.r > rgb.b ? rgb.r : rgb.b) : (rgb.g > rgb.b ? rgb.g : rgb.b);
+    unsigned int min = rgb.r < rgb.g ? (rgb.r < rgb.b ? rgb.r : rgb.b) : (rgb.g < rgb.b ? rgb.g : rgb.b);
+    unsigned int diff = max - min, d = diff, steps = 0, num;
+    if (!diff) {return CYC_COMMON;}
+    while (d > 255) {d >>= 1; steps++;}
+    while (d < 128) {d <<= 1; steps++;}
+    if (rgb.r == max) {num = rgb.g > rgb.b ? rgb.g - rgb.b : rgb.b - rgb.g;}
+    else if (rgb.g == max) {num = rgb.b > rgb.r ? rgb.b - rgb.r : rgb.r - rgb.b;}
+    else {num = rgb.r > rgb.g ? rgb.r - rgb.g : rgb.g - rgb.r;}
+    return CYC_COMMON + steps * CYC_NORM_STEP + CYC_TABLE + CYC_MUL32 + CYC_ROUND
+        + CYC_REMAINDER + corrections(num, diff) * CYC_CORRECT;
+}
+
+// error statistics of one kernel
+typedef struct STATS {
+    double max, sum;
+    unsigned long n, worst[3];      // count, and the RGB triple of the largest error
+} STATS;
+
+static void addError(STATS *s, RGB rgb, double h, double ref) {
+    double e = h > ref ? h - ref : ref - h;
+    if (e > 1800) {e = 3600 - e;}   // around the circle
+    s->sum += e;
+    s->n++;
+    if (e > s->max) {
+        s->max = e;
+        s->worst[0] = rgb.r;
+        s->worst[1] = rgb.g;
+        s->worst[2] = rgb.b;
+    }
+}
+
+static void printStats(const char *name, STATS *s) {
+    printf("  %-26s max %8.2f  mean %7.3f  (worst at r %lu g %lu b %lu)\n",
+           name, s->max, s->sum / s->n, s->worst[0], s->worst[1], s->worst[2]);
+}
+
+static unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long random32(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng >> 32;
+}
+
+/************************************************
+ *  Function to add one triple to the statistics of every kernel
+ ***********************************************/
+static STATS table, old, divide;
+static unsigned long long cycTable, cycOld;
+static unsigned int cycTableMax;
+
+static void measure(RGB rgb) {
+    double ref = hueReference(rgb);
+    addError(&table, rgb, rgb2hsv(rgb).h, ref);
+    addError(&old, rgb, hueOld(rgb), ref);
+    addError(&divide, rgb, hueDivide(rgb), ref);
+
+    unsigned int c = cyclesTable(rgb);
+    cycTable += c;
+    if (c > cycTableMax) {cycTableMax = c;}
+    cycOld += cyclesOld(rgb);
+}
+
+/************************************************
+ *  Function to check hueRatio against the rounded ratio (600 * num + diff / 2) / diff
+ *  for every num <= diff, and count the correction steps it takes
+ *  Returns the number of pairs that differ
+ ***********************************************/
+static unsigned long ratioSweep(unsigned int from, unsigned int to) {
+    unsigned long n = 0, wrong = 0, maxSteps = 0, steps = 0;
+    unsigned int worstNum = 0, worstDiff = 0;
+    for (unsigned long diff = from; diff <= to; diff++) {
+        for (unsigned long num = 0; num <= diff; num++) {
+            unsigned int h = hueRatio(num, diff);
+            if (h != (600 * num + diff / 2) / diff) {
+                if (!wrong) {worstNum = num; worstDiff = diff;}
+                wrong++;
+            }
+            n++;
+        }
+        for (unsigned long num = 0; num <= diff; num += 1 + diff / 64) {   // the estimate, sampled
+            unsigned int c = corrections(num, diff);
+            steps += c;
+            if (c > maxSteps) {maxSteps = c;}
+        }
+    }
+    printf("hueRatio, diff %u..%u, every num <= diff (%lu pairs): %lu differ from the rounded ratio",
+           from, to, n, wrong);
+    if (wrong) {printf(" (first at num %u diff %u)", worstNum, worstDiff);}
+    printf(", up to %lu correction steps\n", maxSteps);
+    return wrong;
+}
+
+/************************************************
+ *  Function to time a hue kernel on the host
+ ***********************************************/
+static RGB timing[TIMING_SAMPLES];
+static volatile unsigned int sink;
+
+static double hostNs(unsigned int (*kernel)(RGB)) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned int p = 0; p < TIMING_PASSES; p++) {
+        for (unsigned int i = 0; i < TIMING_SAMPLES; i++) {sink = kernel(timing[i]);}
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ((double)TIMING_PASSES * TIMING_SAMPLES);
+}
+
+static unsigned int hueTable(RGB rgb) {
+    return rgb2hsv(rgb).h;
+}
+
+int main(void) {
+    unsigned long wrong = ratioSweep(1, 255) + ratioSweep(256, 65535);
+
+    for (unsigned char k = 0; k < sizeof(scales) / sizeof(scales[0]); k++) {
+        unsigned long full = scales[k];
+        table = old = divide = (STATS){0};
+        cycTable = cycOld = 0;
+        cycTableMax = 0;
+
+        for (unsigned int i = 0; i < GRID; i++) {
+            for (unsigned int j = 0; j < GRID; j++) {
+                for (unsigned int l = 0; l < GRID; l++) {
+                    RGB rgb = {i * full / (GRID - 1), j * full / (GRID - 1), l * full / (GRID - 1), 0};
+                    measure(rgb);
+                }
+            }
+        }
+        for (unsigned long i = 0; i < RANDOM; i++) {
+            RGB rgb = {random32() % (full + 1), random32() % (full + 1), random32() % (full + 1), 0};
+            measure(rgb);
+        }
+
+        printf("\nfull scale %lu: %lu triples (%u^3 grid and %u random), hue error in 0.1 deg\n",
+               full, table.n, GRID, RANDOM);
+        printStats("reciprocal table", &table);
+        printStats("old 16 bit division", &old);
+        printStats("division without overflow", &divide);
+        printf("  estimated PIC18 cycles       table mean %.0f max %u, old division %.0f\n",
+               (double)cycTable / table.n, cycTableMax, (double)cycOld / old.n);
+    }
+
+    for (unsigned int i = 0; i < TIMING_SAMPLES; i++) {
+        RGB rgb = {random32() % 65536, random32() % 65536, random32() % 65536, 0};
+        timing[i] = rgb;
+    }
+    printf("\nhost time per conversion: table %.1f ns (whole rgb2hsv), old division %.1f ns\n",
+           hostNs(hueTable), hostNs(hueOld));
+    printf("(the host divides in hardware, so only the PIC18 estimate reflects the target)\n");
+    return wrong ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "mssp.h"
+
+// bus actions, named after the action in progress
+#define BUS_NONE   0
+#define BUS_START  1
+#define BUS_RSTART 2
+#define BUS_STOP   3
+#define BUS_WRITE  4
+#define BUS_READ   5
+#define BUS_ACK    6
+
+char msspTrace[MSSP_TRACE_SIZE];        // "S" start, "Sr" repeated start, "W52+" byte written and acknowledged,
+                                        // "W60-" not acknowledged, "R11A"/"R11N" byte read and (not) acknowledged, "P" stop,
+                                        // "C" bus collision
+unsigned char msspCollide = 0;
+unsigned char msspStuck = 0;
+static I2C_SLAVE *device = 0;           // device on the bus
+static unsigned char action = BUS_NONE; // bus action in progress
+static long remaining;                  // ns until the action completes
+static unsigned char held = 0;          // bus held between a start and a stop
+static unsigned char awaiting = 0;      // an action completed and the firmware has not started the next
+static unsigned char addressed;         // the address byte after the last start has been sent
+static unsigned char selected;          // the device acknowledged its address
+static unsigned char reading;           // the address byte had R/W set
+static unsigned char txByte;            // byte being written
+
+/************************************************
+ *  Function to add an event to the bus trace
+ ***********************************************/
+static void trace(const char *event) {
+    size_t used = strlen(msspTrace);
+    snprintf(msspTrace + used, MSSP_TRACE_SIZE - used, used ? " %s" : "%s", event);
+}
+
+/************************************************
+ *  Function to connect a device to the bus
+ ***********************************************/
+void msspAttach(I2C_SLAVE *slave) {
+    device = slave;
+}
+
+/************************************************
+ *  Function to release the bus and clear the trace
+ ***********************************************/
+void msspReset(void) {
+    action = BUS_NONE;
+    held = 0;
+    awaiting = 0;
+    msspCollide = 0;
+    msspStuck = 0;
+    msspTrace[0] = 0;
+}
+
+/************************************************
+ *  Function to check if the bus is released with nothing in progress
+ ***********************************************/
+unsigned char msspIdle(void) {
+    return action == BUS_NONE && !held;
+}
+
+/************************************************
+ *  Function to start the next bus action requested by the firmware
+ *  A byte write is recognised by SSP2IF having been cleared after the last
+ *  action without any SSP2CON2 action being requested, as SSP2BUF was written
+ ***********************************************/
+static void begin(void) {
+    if (SSP2CON2bits.SEN) {action = BUS_START; remaining = MSSP_START_NS;}
+    else if (SSP2CON2bits.RSEN) {action = BUS_RSTART; remaining = MSSP_START_NS;}
+    else if (SSP2CON2bits.PEN) {action = BUS_STOP; remaining = MSSP_START_NS;}
+    else if (SSP2CON2bits.RCEN) {action = BUS_READ; remaining = MSSP_BYTE_NS - MSSP_ACK_NS;}
+    else if (SSP2CON2bits.ACKEN) {action = BUS_ACK; remaining = MSSP_ACK_NS;}
+    else if (held && awaiting && !PIR3bits.SSP2IF) {
+        action = BUS_WRITE;
+        remaining = MSSP_BYTE_NS;
+        txByte = SSP2BUF;
+        SSP2STATbits.R_nW = 1;          // transmit in progress
+        SSP2STATbits.BF = 1;
+    }
+    else {return;}
+    awaiting = 0;
+
+    // another master won the bus: the MSSP drops the action, releases the bus and raises BCL2IF
+    if (msspCollide) {
+        msspCollide = 0;
+        SSP2CON2 = 0;
+        SSP2STATbits.BF = 0;
+        SSP2STATbits.R_nW = 0;
+        trace("C");
+        action = BUS_NONE;
+        held = 0;
+        selected = 0;
+        PIR3bits.BCL2IF = 1;
+    }
+}
+
+/************************************************
+ *  Function to finish the bus action in progress and raise SSP2IF
+ ***********************************************/
+static void complete(void) {
+    char event[8];
+
+    switch (action) {
+        case BUS_START:
+        case BUS_RSTART:
+            SSP2CON2bits.SEN = 0;
+            SSP2CON2bits.RSEN = 0;
+            SSP2STATbits.S = 1;
+            SSP2STATbits.P = 0;
+            trace(action == BUS_START ? "S" : "Sr");
+            held = 1;
+            addressed = 0;
+            break;
+
+        case BUS_STOP:
+            SSP2CON2bits.PEN = 0;
+            SSP2STATbits.S = 0;
+            SSP2STATbits.P = 1;
+            trace("P");
+            if (device && selected) {device->stop();}
+            held = 0;
+            selected = 0;
+            break;
+
+        case BUS_WRITE: {
+            unsigned char ack;
+            SSP2STATbits.R_nW = 0;
+            SSP2STATbits.BF = 0;
+            if (!addressed) {
+                addressed = 1;
+                reading = txByte & 0x01;
+                selected = device && device->address(txByte);
+                ack = selected;
+            } else {
+                ack = selected && !reading && device->write(txByte);
+            }
+            SSP2CON2bits.ACKSTAT = !ack;
+            snprintf(event, sizeof(event), "W%02X%c", txByte, ack ? '+' : '-');
+            trace(event);
+            break;
+        }
+
+        case BUS_READ:
+            SSP2CON2bits.RCEN = 0;
+            SSP2BUF = selected && reading ? device->read() : 0xFF;  // the bus floats high with no device driving it
+            SSP2STATbits.BF = 1;
+            break;
+
+        case BUS_ACK:
+            SSP2CON2bits.ACKEN = 0;
+            SSP2STATbits.BF = 0;
+            snprintf(event, sizeof(event), "R%02X%c", SSP2BUF, SSP2CON2bits.ACKDT ? 'N' : 'A');
+            trace(event);
+            break;
+    }
+
+    action = BUS_NONE;
+    awaiting = held;
+    PIR3bits.SSP2IF = 1;                // bus event complete
+}
+
+/************************************************
+ *  Function to advance the bus by ns
+ *  Each call completes at most one bus action
+ ***********************************************/
+void msspStep(unsigned long ns) {
+    if (!SSP2CON1bits.SSPEN) {return;}
+    if (action == BUS_NONE) {begin();}
+    if (action == BUS_NONE || msspStuck) {return;}
+
+    remaining -= ns;
+    if (remaining <= 0) {complete();}
+}
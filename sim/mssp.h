@@ -0,0 +1,31 @@
+#ifndef _mssp_H
+#define _mssp_H
+
+/************************************************
+ *  Host model of MSSP2 in I2C master mode
+ *  Bus actions started through SSP2CON2 or SSP2BUF complete after their
+ *  bus time at 100kHz and raise SSP2IF, as the hardware does
+ ***********************************************/
+
+#define MSSP_START_NS 5000      // start, repeated start and stop conditions
+#define MSSP_BYTE_NS 90000      // 8 data bits and the acknowledge bit
+#define MSSP_ACK_NS 10000       // acknowledge sequence after a received byte
+#define MSSP_TRACE_SIZE 512     // characters kept in the bus trace
+
+typedef struct I2C_SLAVE {                      // definition of a device on the simulated bus
+    unsigned char (*address)(unsigned char byte);   // address byte (R/W in bit 0), returns 1 to acknowledge
+    unsigned char (*write)(unsigned char byte);     // data byte from the master, returns 1 to acknowledge
+    unsigned char (*read)(void);                    // next data byte for the master
+    void (*stop)(void);                             // stop condition
+} I2C_SLAVE;
+
+extern char msspTrace[MSSP_TRACE_SIZE];        // bus events since the last msspReset, see mssp.c
+extern unsigned char msspCollide;               // set to lose the next bus action to another master
+extern unsigned char msspStuck;                 // set to hold the bus so no action completes
+
+void msspAttach(I2C_SLAVE *slave);
+void msspReset(void);
+void msspStep(unsigned long ns);
+unsigned char msspIdle(void);
+
+#endif
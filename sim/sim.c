@@ -0,0 +1,568 @@
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "color.h"
+#include "dc_motor.h"
+#include "eeprom.h"
+#include "hardware.h"
+#include "interrupts.h"
+#include "map.h"
+#include "navigate.h"
+#include "sequence.h"
+#include "structures.h"
+#include "telemetry.h"
+#include "mssp.h"
+#include "tcs3471.h"
+
+/************************************************
+ *  Simulated buggy in a grid maze, linked against the unmodified firmware
+ *  The firmware objects are built with -finstrument-functions. Every function
+ *  call is charged SIM_CALL_NS of simulated time, which steps the peripheral
+ *  models and dispatches HighISR, so busy waits and the scheduler loop see
+ *  time pass exactly as on the target. Everything is deterministic for a seed
+ ***********************************************/
+
+#define SIM_CALL_NS 2000            // instruction time charged for each firmware function call
+#define SIM_STEP_NS 10000           // peripheral model step
+#define SIM_TICK_STEPS 100          // model steps per 1ms timer 4 tick and physics step
+#define UART_BYTE_NS 86800          // 10 bits at 115200 bps
+#define PRESS_MS 200                // time the start button is pressed, after power up
+#define PRESS_LENGTH 100            // ms the start button is held
+
+// buggy geometry and drive. The drive is a model of its own, not the firmware's
+// odometer: the motors differ, have a deadband, a slower response and run off a
+// battery that sags under load and drains, and the wheels stall against a wall.
+// The trimmed motors make a square about the 2.5s reverse at power 20 (MAP_CELL)
+// and the default turn table turns about 90 deg
+#define CELL 0.3                    // square size (m)
+#define VMAX 0.685                  // left wheel speed at full drive on a full battery (m/s)
+#define MOTOR_RIGHT 0.94            // right motor speed relative to the left
+#define DEADBAND 0.06               // drive the motors need before they turn
+#define TAU 0.040                   // motor time constant (s)
+#define SAG_LOAD 0.05               // supply drop with both motors at full drive
+#define SAG_RATE 0.0008             // supply drop per second of the run as the battery drains
+#define STILL 0.01                  // speed (m/s) taken as at rest
+#define TRACK 0.133                 // wheel track (m)
+#define FRONT 0.08                  // centre to sensor (m)
+#define REAR 0.08                   // centre to rear bumper (m)
+#define ALIGN_RATE 1.0              // rate (rad/s) the buggy squares up while pushing into a wall
+#define ALIGN_RANGE 0.9             // largest misalignment (rad) that squares up
+#define CONTACT 0.02                // sensor to wall distance (m) taken as reaching a card, classified samples are scored from here
+
+// light reaching the sensor in counts per 2.4ms cycle at 1x gain (c, r, g, b)
+#define FALLOFF 0.03                // distance (m) at which reflected light is half its contact value
+static const double ambient[4] = {18, 5, 6, 5};     // room light with nothing in front of the sensor
+static const double led[3] = {90, 80, 70};          // red, green and blue LED reflected by a white card
+static const double reflect[9][3] = {               // card reflectance, in the firmware colour order
+    {0.80, 0.15, 0.15},     // red
+    {0.15, 0.60, 0.20},     // green
+    {0.10, 0.20, 0.70},     // blue
+    {0.85, 0.80, 0.20},     // yellow
+    {0.90, 0.45, 0.60},     // pink
+    {0.90, 0.45, 0.10},     // orange
+    {0.40, 0.70, 0.90},     // light blue
+    {0.90, 0.90, 0.90},     // white
+    {0.05, 0.05, 0.04},     // black (plain wall)
+};
+static const char *colourName[9] = {"red", "green", "blue", "yellow", "pink", "orange", "lightblue", "white", "black"};
+
+#define MAZE_MAX 16                 // squares along each side of the largest maze
+#define CARDS_MAX 64                // wall contacts recorded
+
+void firmware_main(void);           // main() of main.c, renamed by the host build
+
+// maze walls, 0: open, otherwise colour + 1 of the face seen from each side
+static int width, height;
+static unsigned char hface[MAZE_MAX + 1][MAZE_MAX][2];  // line y = j: [0] seen from the south, [1] from the north
+static unsigned char vface[MAZE_MAX][MAZE_MAX + 1][2];  // line x = i: [0] seen from the west, [1] from the east
+static double startX, startY, startTheta;
+
+// buggy state, theta clockwise from north
+static double px, py, theta, vL, vR;
+static double backed = 0;                           // distance backed away from the last card (m)
+static double backoff[CARDS_MAX];                   // distance backed away from each card (m)
+
+// simulation state
+static unsigned long long now = 0, nextStep = 0;   // simulated time (ns)
+static unsigned long steps = 0;                     // peripheral steps taken
+static unsigned char running = 0;                   // the firmware is being simulated
+static unsigned char inIsr = 0;                     // HighISR is running
+static unsigned long uartBusy = 0;                  // ns until the transmit register is free
+static jmp_buf simExit;
+static unsigned long long limit = 600000000000ULL;  // simulated time limit (ns)
+static unsigned long long startNs = 0;              // end of the start button press
+static unsigned char finished = 0;
+static unsigned int verbose = 0;                    // ms between pose traces (0: off)
+
+// telemetry capture and classification accuracy
+static FILE *capture = 0;
+static unsigned char frame[4 + TELEMETRY_MAX_LEN + 1];
+static unsigned char frameLen = 0;
+static unsigned long frames = 0;
+static unsigned int dropped = 0;                    // frames the buggy could not send, from the last sample
+static unsigned char touching = 0;
+static unsigned char cards = 0;
+static unsigned char truth[CARDS_MAX];              // colour of each wall contacted
+static unsigned int votes[CARDS_MAX][9];            // classified samples of each contact
+static unsigned long classified = 0, correct = 0;
+
+/************************************************
+ *  Function to cast a ray against the maze walls
+ *  Returns the distance to the nearest wall face and its colour + 1 (0 if none)
+ ***********************************************/
+static double rayCast(double x, double y, double ux, double uy, unsigned char *face) {
+    double best = INFINITY;
+    *face = 0;
+
+    if (fabs(uy) > 1e-9) {
+        for (int j = 0; j <= height; j++) {
+            double t = (j * CELL - y) / uy;
+            if (t < -0.05 || t >= best) {continue;}
+            int i = (int)floor((x + t * ux) / CELL);
+            if (i < 0 || i >= width) {continue;}
+            unsigned char f = hface[j][i][uy > 0 ? 0 : 1];
+            if (f) {best = t; *face = f;}
+        }
+    }
+    if (fabs(ux) > 1e-9) {
+        for (int i = 0; i <= width; i++) {
+            double t = (i * CELL - x) / ux;
+            if (t < -0.05 || t >= best) {continue;}
+            int j = (int)floor((y + t * uy) / CELL);
+            if (j < 0 || j >= height) {continue;}
+            unsigned char f = vface[j][i][ux > 0 ? 0 : 1];
+            if (f) {best = t; *face = f;}
+        }
+    }
+    return best;
+}
+
+/************************************************
+ *  Function to find the wall in front of the sensor
+ ***********************************************/
+static double sensorWall(unsigned char *face) {
+    return rayCast(px + FRONT * sin(theta), py + FRONT * cos(theta), sin(theta), cos(theta), face);
+}
+
+/************************************************
+ *  Function to give the light reaching the sensor from a wall face at distance d
+ *  The wall shades the room light and reflects the LEDs as it gets closer
+ ***********************************************/
+static void lightFrom(double d, unsigned char face, unsigned char red, unsigned char green, unsigned char blue, double crgb[4]) {
+    double s = 0;
+    if (face) {
+        double x = (d < 0 ? 0 : d) / FALLOFF;
+        s = 1 / (1 + x * x * x * x);
+    }
+    const double *refl = face ? reflect[face - 1] : reflect[8];
+    double r = red ? led[0] * refl[0] : 0;
+    double g = green ? led[1] * refl[1] : 0;
+    double b = blue ? led[2] * refl[2] : 0;
+
+    crgb[0] = ambient[0] * (1 - s) + s * 0.9 * (r + g + b);
+    crgb[1] = ambient[1] * (1 - s) + s * r;
+    crgb[2] = ambient[2] * (1 - s) + s * g;
+    crgb[3] = ambient[3] * (1 - s) + s * b;
+}
+
+/************************************************
+ *  Function to give the light reaching the sensor, called by the sensor model each cycle
+ ***********************************************/
+static void sensorLight(double crgb[4]) {
+    unsigned char face;
+    double d = sensorWall(&face);
+    lightFrom(d, face, RED_LED, GREEN_LED, BLUE_LED, crgb);
+}
+
+/************************************************
+ *  Function to read a 10 bit right aligned CCP duty
+ ***********************************************/
+static double duty(unsigned char high, unsigned char low) {
+    return ((unsigned int)high << 8 | low) & 0x3FF;
+}
+
+/************************************************
+ *  Function to give the speed a motor settles to for a drive (-1 to 1)
+ ***********************************************/
+static double motorSpeed(double drive, double gain, double supply) {
+    double d = fabs(drive) - DEADBAND;
+    if (d <= 0) {return 0;}
+    return copysign(gain * VMAX * supply * d / (1 - DEADBAND), drive);
+}
+
+/************************************************
+ *  Function to advance the buggy by one 1ms physics step
+ *  Each wheel follows the speed its motor settles to with a first order lag.
+ *  A wall stops the buggy and stalls both wheels, and pushing into it squares the buggy up
+ ***********************************************/
+static void physics(double dt) {
+    double period = (T2PR + 1) * 4.0;
+    double driveL = 0, driveR = 0;
+    if (T2CONbits.ON) {
+        driveL = (duty(CCPR2H, CCPR2L) - duty(CCPR1H, CCPR1L)) / period;  // -ve side minus +ve side
+        driveR = (duty(CCPR4H, CCPR4L) - duty(CCPR3H, CCPR3L)) / period;
+    }
+    double supply = 1 - SAG_LOAD * (fabs(driveL) + fabs(driveR)) / 2 - SAG_RATE * now * 1e-9;
+    vL += (motorSpeed(driveL, 1, supply) - vL) * dt / TAU;
+    vR += (motorSpeed(driveR, MOTOR_RIGHT, supply) - vR) * dt / TAU;
+
+    theta += (vL - vR) / TRACK * dt;
+    double ds = (vL + vR) / 2 * dt;
+    unsigned char face;
+
+    if (ds > 0) {
+        double d = sensorWall(&face);
+        if (ds > d) {
+            ds = d > 0 ? d : 0;
+            vL = vR = 0;
+            double square = round(theta / (M_PI / 2)) * (M_PI / 2);
+            double err = square - theta;
+            if (fabs(err) < ALIGN_RANGE) {theta += fabs(err) < ALIGN_RATE * dt ? err : copysign(ALIGN_RATE * dt, err);}
+        }
+    } else if (ds < 0) {
+        double d = rayCast(px - REAR * sin(theta), py - REAR * cos(theta), -sin(theta), -cos(theta), &face);
+        if (-ds > d) {ds = d > 0 ? -d : 0; vL = vR = 0;}
+    }
+    px += ds * sin(theta);
+    py += ds * cos(theta);
+
+    // measure each back off from a card until the buggy comes to rest
+    if (ds < -STILL * dt && cards && (touching || backed > 0)) {backed -= ds;}
+    else if (ds >= -STILL * dt && backed > 0) {
+        backoff[cards - 1] = backed;
+        backed = 0;
+    }
+}
+
+/************************************************
+ *  Function to decode a telemetry byte, scoring each classified sample
+ *  against the colour of the last wall the buggy touched
+ ***********************************************/
+static void telemetryByte(unsigned char byte) {
+    if (capture) {fputc(byte, capture);}
+
+    if ((frameLen == 0 && byte != TELEMETRY_SYNC1) || (frameLen == 1 && byte != TELEMETRY_SYNC2)) {
+        frameLen = byte == TELEMETRY_SYNC1;
+        return;
+    }
+    frame[frameLen++] = byte;
+    if (frameLen < 4) {return;}
+    if (frame[3] > TELEMETRY_MAX_LEN) {frameLen = 0; return;}
+    if (frameLen < 5 + frame[3]) {return;}
+
+    unsigned char sum = 0;
+    for (unsigned char i = 2; i < frameLen; i++) {sum += frame[i];}
+    frameLen = 0;
+    if (sum) {return;}
+    frames++;
+
+    if (frame[2] != TELEMETRY_SAMPLE) {return;}
+    dropped = frame[4 + 25] | frame[4 + 26] << 8;
+    unsigned char cls = frame[4 + 19];
+    if (cls == TELEMETRY_NO_CLASS || cls > 8 || cards == 0) {return;}
+    classified++;
+    votes[cards - 1][cls]++;
+    if (cls == truth[cards - 1]) {correct++;}
+}
+
+/************************************************
+ *  Function to run the test scenario once per 1ms tick
+ *  Presses the start button and records each contact with a wall
+ ***********************************************/
+static void scenario(void) {
+    unsigned long ms = now / 1000000;
+    unsigned char pressed = ms >= PRESS_MS && ms < PRESS_MS + PRESS_LENGTH;
+    PORTFbits.RF2 = !pressed;                   // buttons are active low
+    PORTFbits.RF3 = 1;
+    if (ms == PRESS_MS + PRESS_LENGTH) {startNs = now;}
+
+    unsigned char face;
+    double d = sensorWall(&face);
+    if (verbose && ms % verbose == 0) {
+        printf("%7.3f s  x %5.3f  y %5.3f  heading %6.1f  wheels %+5.2f %+5.2f  wall %s %.3f\n", now * 1e-9,
+               px / CELL, py / CELL, theta * 180 / M_PI, vL, vR, face ? colourName[face - 1] : "-", d);
+    }
+    if (!touching && face && d < CONTACT && cards < CARDS_MAX) {
+        truth[cards++] = face - 1;
+    }
+    if (touching && (!face || d > 2 * CONTACT)) {touching = 0;}     // backed away from the card
+    else if (face && d < CONTACT) {touching = 1;}
+
+    if (now >= limit) {longjmp(simExit, 1);}
+}
+
+/************************************************
+ *  Function to step the peripheral models by SIM_STEP_NS
+ ***********************************************/
+static void peripherals(void) {
+    msspStep(SIM_STEP_NS);
+    tcsStep(SIM_STEP_NS);
+
+    if (uartBusy) {
+        uartBusy = uartBusy > SIM_STEP_NS ? uartBusy - SIM_STEP_NS : 0;
+        if (!uartBusy) {PIR4bits.TX4IF = 1;}    // transmit register free
+    }
+
+    if (++steps % SIM_TICK_STEPS == 0) {
+        if (T4CONbits.ON) {PIR5bits.TMR4IF = 1;}
+        physics(SIM_STEP_NS * SIM_TICK_STEPS * 1e-9);
+        scenario();
+    }
+}
+
+/************************************************
+ *  Function to check for an enabled interrupt flag
+ ***********************************************/
+static unsigned char pending(void) {
+    if (!INTCONbits.GIE) {return 0;}
+    if (PIE0bits.TMR0IE && PIR0bits.TMR0IF) {return 1;}
+    if (!INTCONbits.PEIE) {return 0;}
+    return (PIE5bits.TMR4IE && PIR5bits.TMR4IF) || (PIE5bits.TMR1IE && PIR5bits.TMR1IF)
+        || (PIE3bits.SSP2IE && (PIR3bits.SSP2IF || PIR3bits.BCL2IF)) || (PIE4bits.TX4IE && PIR4bits.TX4IF)
+        || (PIE4bits.RC4IE && PIR4bits.RC4IF);
+}
+
+/************************************************
+ *  Function to start sending the byte the firmware loaded into TX4REG
+ ***********************************************/
+static void uartLoad(void) {
+    unsigned char byte = TX4REG;
+    hal_sim_tx_loaded = 0;
+    PIR4bits.TX4IF = 0;
+    uartBusy = UART_BYTE_NS;
+    telemetryByte(byte);
+}
+
+/************************************************
+ *  Function to advance simulated time, then run HighISR if an interrupt is
+ *  pending, as the CPU would between instructions
+ *  Inside HighISR a load of TX4REG may not have been stored yet, so it is
+ *  picked up once the ISR returns
+ ***********************************************/
+static void simAdvance(unsigned long ns) {
+    if (hal_sim_tx_loaded && !inIsr) {uartLoad();}
+    now += ns;
+    while (now >= nextStep) {
+        nextStep += SIM_STEP_NS;
+        peripherals();
+    }
+    if (inIsr || !pending()) {return;}
+
+    inIsr = 1;
+    HighISR();
+    inIsr = 0;
+    if (hal_sim_tx_loaded) {uartLoad();}
+}
+
+/************************************************
+ *  Function to spend the time of an XC8 delay, interrupts keep running
+ ***********************************************/
+static void simDelay(unsigned long us) {
+    for (unsigned long long ns = (unsigned long long)us * 1000; ns > 0; ) {
+        unsigned long chunk = ns > SIM_STEP_NS ? SIM_STEP_NS : ns;
+        simAdvance(chunk);
+        ns -= chunk;
+    }
+}
+
+/************************************************
+ *  Functions called on entry to and exit from every instrumented firmware function
+ ***********************************************/
+void __cyg_profile_func_enter(void *fn, void *site) {
+    (void)fn; (void)site;
+    if (running) {simAdvance(SIM_CALL_NS);}
+}
+
+void __cyg_profile_func_exit(void *fn, void *site) {
+    (void)site;
+    if (running && fn == (void *)backtrack) {   // the buggy is home, the run is over
+        finished = 1;
+        longjmp(simExit, 1);
+    }
+}
+
+/************************************************
+ *  Function to add a wall face on one side of a square
+ *  The other face of the wall is a plain black wall unless it was set already
+ ***********************************************/
+static void setWall(int x, int y, char side, unsigned char colour) {
+    unsigned char *face, *back;
+    switch (side) {
+        case 'N': face = &hface[y + 1][x][0]; back = &hface[y + 1][x][1]; break;
+        case 'S': face = &hface[y][x][1];     back = &hface[y][x][0];     break;
+        case 'E': face = &vface[y][x + 1][0]; back = &vface[y][x + 1][1]; break;
+        default:  face = &vface[y][x][1];     back = &vface[y][x][0];     break;
+    }
+    *face = colour + 1;
+    if (!*back) {*back = 8 + 1;}
+}
+
+/************************************************
+ *  Function to load a maze description
+ *    size W H                  squares across and up (black walls around the edge)
+ *    start X Y N|E|S|W         starting square and heading
+ *    wall X Y N|E|S|W          plain wall on one side of a square
+ *    card X Y N|E|S|W COLOUR   card on the face of a wall seen from square X Y
+ *  Lines starting with # are comments
+ ***********************************************/
+static int loadMaze(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {perror(path); return 0;}
+
+    char line[128], side, name[32];
+    int x, y;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {continue;}
+        if (sscanf(line, "size %d %d", &x, &y) == 2) {
+            if (x < 1 || y < 1 || x > MAZE_MAX || y > MAZE_MAX) {fprintf(stderr, "%s: bad size\n", path); fclose(f); return 0;}
+            width = x;
+            height = y;
+            for (int i = 0; i < width; i++) {setWall(i, 0, 'S', 8); setWall(i, height - 1, 'N', 8);}
+            for (int j = 0; j < height; j++) {setWall(0, j, 'W', 8); setWall(width - 1, j, 'E', 8);}
+        } else if (sscanf(line, "start %d %d %c", &x, &y, &side) == 3) {
+            startX = (x + 0.5) * CELL;
+            startY = (y + 0.5) * CELL;
+            startTheta = (strchr("NESW", side) - "NESW") * M_PI / 2;
+        } else if (sscanf(line, "wall %d %d %c", &x, &y, &side) == 3 && width) {
+            setWall(x, y, side, 8);
+        } else if (sscanf(line, "card %d %d %c %31s", &x, &y, &side, name) == 4 && width) {
+            unsigned char c = 0;
+            while (c < 9 && strcmp(name, colourName[c])) {c++;}
+            if (c == 9) {fprintf(stderr, "%s: unknown colour %s\n", path, name); fclose(f); return 0;}
+            setWall(x, y, side, c);
+        } else {
+            fprintf(stderr, "%s: can not parse: %s", path, line);
+            fclose(f);
+            return 0;
+        }
+    }
+    fclose(f);
+    if (!width) {fprintf(stderr, "%s: no size given\n", path); return 0;}
+    return 1;
+}
+
+/************************************************
+ *  Function to store a colour calibration in the EEPROM, as storeCalibration
+ *  would with the sensor pressed against each card under the LEDs
+ ***********************************************/
+static void calibrate(void) {
+    HSV cal[9];
+    unsigned int cycles = 256 - 0xD5;           // classify profile, 1x gain
+
+    for (unsigned char i = 0; i < 9; i++) {
+        double crgb[4];
+        lightFrom(0, i + 1, 1, 1, 1, crgb);
+        RGB rgb;
+        rgb.c = crgb[0] * cycles + 0.5;
+        rgb.r = crgb[1] * cycles + 0.5;
+        rgb.g = crgb[2] * cycles + 0.5;
+        rgb.b = crgb[3] * cycles + 0.5;
+        cal[i] = rgb2hsv(rgb);
+    }
+    eepromSave(CAL_EEPROM, CAL_VERSION, (unsigned char *)cal, sizeof(cal));
+}
+
+/************************************************
+ *  Function to give the drive of a trimmed motor table entry, as motorTable
+ ***********************************************/
+static double trimmedDrive(unsigned int gain, unsigned char offset, unsigned char p) {
+    unsigned int top = ((unsigned long)gain * MOTOR_MAX) >> 8;
+    return (offset + (double)((unsigned int)p * (top - offset) / MOTOR_MAX)) / MOTOR_MAX;
+}
+
+/************************************************
+ *  Function to store a motor trim in the EEPROM, as the trim calibration would
+ *  leave it: both deadbands covered and the faster left motor turned down to
+ *  the button press that runs straightest at TRIM_POWER
+ ***********************************************/
+static void trimMotors(void) {
+    MOTOR_TRIM t;
+    t.offset[0] = t.offset[1] = (unsigned char)ceil(DEADBAND * MOTOR_MAX / TRIM_OFFSET_STEP) * TRIM_OFFSET_STEP;
+    t.gain[1] = 256;
+    double right = motorSpeed(trimmedDrive(256, t.offset[1], TRIM_POWER), MOTOR_RIGHT, 1);
+    double best = INFINITY;
+    for (unsigned int g = 256; g > 128; g -= TRIM_GAIN_STEP) {
+        double error = fabs(motorSpeed(trimmedDrive(g, t.offset[0], TRIM_POWER), 1, 1) - right);
+        if (error < best) {best = error; t.gain[0] = g;}
+    }
+    eepromSave(TRIM_EEPROM, TRIM_VERSION, (unsigned char *)&t, sizeof(t));
+}
+
+int main(int argc, char **argv) {
+    unsigned long seed = 1;
+    const char *maze = 0, *out = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {seed = strtoul(argv[++i], 0, 0);}
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {tcsNoise = atof(argv[++i]);}
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) {limit = (unsigned long long)(atof(argv[++i]) * 1e9);}
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) {out = argv[++i];}
+        else if (!strcmp(argv[i], "-v") && i + 1 < argc) {verbose = atoi(argv[++i]);}
+        else if (argv[i][0] != '-') {maze = argv[i];}
+        else {maze = 0; break;}
+    }
+    if (!maze) {
+        fprintf(stderr, "usage: %s [-s seed] [-n noise] [-t seconds] [-o telemetry.bin] [-v ms] maze.txt\n", argv[0]);
+        return 2;
+    }
+    if (!loadMaze(maze)) {return 2;}
+    if (out && !(capture = fopen(out, "wb"))) {perror(out); return 2;}
+
+    // power up: buttons released, transmit register empty, EEPROM erased except the calibrations
+    px = startX;
+    py = startY;
+    theta = startTheta;
+    PORTFbits.RF2 = 1;
+    PORTFbits.RF3 = 1;
+    PIR4bits.TX4IF = 1;
+    memset(hal_sim_eeprom, 0xFF, sizeof(hal_sim_eeprom));
+    calibrate();
+    trimMotors();
+
+    msspAttach(&tcsSlave);
+    tcsReset(seed);
+    tcsLight = sensorLight;
+    hal_sim_delay = simDelay;
+
+    running = 1;
+    if (!setjmp(simExit)) {firmware_main();}
+    running = 0;
+    if (capture) {fclose(capture);}
+
+    // report the run
+    double dx = (px - startX) / CELL, dy = (py - startY) / CELL;
+    double error = sqrt(dx * dx + dy * dy);
+    double heading = fmod(fmod((theta - startTheta) * 180 / M_PI, 360) + 540, 360) - 180;
+    unsigned char home = finished && error < 0.5;
+    unsigned int decided = 0;
+
+    printf("maze:          %s (seed %lu)\n", maze, seed);
+    printf("result:        %s\n", !finished ? "timed out" : home ? "returned home" : "finished away from home");
+    printf("mine time:     %.2f s\n", (now - startNs) * 1e-9);
+    printf("end position:  %.2f squares from the start, heading %+.0f deg\n", error, heading);
+    for (unsigned char c = 0; c < cards; c++) {
+        unsigned char best = 0;
+        for (unsigned char k = 1; k < 9; k++) {if (votes[c][k] > votes[c][best]) {best = k;}}
+        unsigned char any = votes[c][best] > 0;
+        if (any && best == truth[c]) {decided++;}
+        printf("wall %2u:       %-9s read as %s\n", c + 1, colourName[truth[c]], any ? colourName[best] : "-");
+    }
+    printf("walls read:    %u of %u as the right colour\n", decided, cards);
+    double sum = 0, lo = INFINITY, hi = 0;
+    for (unsigned char c = 0; c < cards; c++) {
+        sum += backoff[c];
+        if (backoff[c] < lo) {lo = backoff[c];}
+        if (backoff[c] > hi) {hi = backoff[c];}
+    }
+    if (cards) {
+        printf("backed off:    %.3f m from each wall (%.3f to %.3f), %u odometer steps is %.3f m\n",
+               sum / cards, lo, hi, REVERSE_DISTANCE, REVERSE_DISTANCE * CELL / MAP_CELL);
+    }
+    printf("samples:       %lu of %lu classified correctly", correct, classified);
+    if (classified) {printf(" (%.1f%%)", 100.0 * correct / classified);}
+    printf(", %lu telemetry frames, %u dropped\n", frames, dropped);
+    return home ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <math.h>
+#include "tcs3471.h"
+
+// registers used by the firmware
+#define REG_ENABLE  0x00
+#define REG_ATIME   0x01
+#define REG_CONTROL 0x0F
+#define REG_ID      0x12
+#define REG_STATUS  0x13
+#define REG_CDATA   0x14
+
+static unsigned char tcsAddressByte(unsigned char byte);
+static unsigned char tcsWrite(unsigned char byte);
+static unsigned char tcsRead(void);
+static void tcsStop(void);
+
+I2C_SLAVE tcsSlave = {tcsAddressByte, tcsWrite, tcsRead, tcsStop};
+void (*tcsLight)(double crgb[4]) = 0;
+double tcsNoise = 1;
+unsigned long tcsIntegrations = 0;
+
+static const unsigned char gainMult[4] = {1, 4, 16, 60};   // AGAIN multiplier
+
+static unsigned char regs[0x20];        // register file
+static unsigned char latch[8];          // CDATA..BDATAH latched by reading CDATA
+static unsigned char pointer;           // register the next access uses
+static unsigned char autoIncrement;     // command type 01, the pointer advances after each access
+static unsigned char command;           // the next byte written is a command byte
+static unsigned long cycleNs;           // time into the current integration cycle
+static unsigned char cycles;            // cycles completed in the current integration
+static double sum[4];                   // light integrated so far (c, r, g, b), counts at the current gain
+static unsigned long long rng;          // noise generator state
+
+/************************************************
+ *  Function to return a uniform random number in (0, 1)
+ ***********************************************/
+static double uniform(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return ((rng >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/************************************************
+ *  Function to return a normally distributed random number
+ ***********************************************/
+static double gaussian(void) {
+    return sqrt(-2 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+/************************************************
+ *  Function to power the sensor down to its reset state
+ ***********************************************/
+void tcsReset(unsigned long seed) {
+    for (unsigned char i = 0; i < sizeof(regs); i++) {regs[i] = 0;}
+    regs[REG_ATIME] = 0xFF;
+    regs[REG_ID] = TCS_ID;
+    pointer = 0;
+    command = 1;
+    cycleNs = 0;
+    cycles = 0;
+    for (unsigned char k = 0; k < 4; k++) {sum[k] = 0;}
+    rng = 0x9E3779B97F4A7C15ULL ^ seed;
+    tcsIntegrations = 0;
+}
+
+/************************************************
+ *  Function to read a register without side effects (for tests)
+ ***********************************************/
+unsigned char tcsRegister(unsigned char address) {
+    return regs[address & 0x1F];
+}
+
+/************************************************
+ *  Function to end an integration, storing the counts and flagging AINT
+ *  Shot noise and read noise are added, then the count saturates at the
+ *  lower of the 16 bit range and 1024 counts per cycle
+ ***********************************************/
+static void integrationDone(void) {
+    unsigned int full = cycles >= 64 ? 65535 : (unsigned int)cycles * 1024;
+
+    for (unsigned char k = 0; k < 4; k++) {
+        double x = sum[k];
+        x += tcsNoise * gaussian() * (1 + 0.002 * x);
+        unsigned int counts = x <= 0 ? 0 : x >= full ? full : (unsigned int)(x + 0.5);
+        regs[REG_CDATA + 2*k] = counts & 0xFF;
+        regs[REG_CDATA + 2*k + 1] = counts >> 8;
+        sum[k] = 0;
+    }
+    regs[REG_STATUS] |= 0x11;           // AVALID and AINT (persistence 0 flags every integration)
+    tcsIntegrations++;
+}
+
+/************************************************
+ *  Function to advance the sensor by ns, integrating the light each cycle
+ ***********************************************/
+void tcsStep(unsigned long ns) {
+    if ((regs[REG_ENABLE] & 0x03) != 0x03) {   // PON and AEN
+        cycleNs = 0;
+        cycles = 0;
+        return;
+    }
+
+    for (cycleNs += ns; cycleNs >= TCS_CYCLE_NS; cycleNs -= TCS_CYCLE_NS) {
+        double light[4] = {0, 0, 0, 0};
+        if (tcsLight) {tcsLight(light);}
+        for (unsigned char k = 0; k < 4; k++) {sum[k] += light[k] * gainMult[regs[REG_CONTROL] & 0x03];}
+
+        if (++cycles >= (unsigned char)(256 - regs[REG_ATIME])) {
+            integrationDone();
+            cycles = 0;
+        }
+    }
+}
+
+/************************************************
+ *  Function to accept the address byte, a write is followed by a command byte
+ ***********************************************/
+static unsigned char tcsAddressByte(unsigned char byte) {
+    if ((byte >> 1) != TCS_ADDRESS) {return 0;}
+    if (!(byte & 0x01)) {command = 1;}
+    return 1;
+}
+
+/************************************************
+ *  Function to accept a command or data byte from the master
+ *  Command: bit 7 set, bits 6-5 type (00 repeated byte, 01 auto-increment,
+ *  11 special function), bits 4-0 register or special function (00110 clears AINT)
+ ***********************************************/
+static unsigned char tcsWrite(unsigned char byte) {
+    if (command) {
+        if (!(byte & 0x80)) {return 0;}
+        command = 0;
+        unsigned char type = (byte >> 5) & 0x03;
+        if (type == 0x03) {
+            if ((byte & 0x1F) == 0x06) {regs[REG_STATUS] &= ~0x10;}  // clear the RGBC interrupt
+            return 1;
+        }
+        pointer = byte & 0x1F;
+        autoIncrement = type == 0x01;
+        return 1;
+    }
+
+    if (pointer < REG_ID) {regs[pointer] = byte;}  // ID, STATUS and the data are read only
+    if (autoIncrement) {pointer = (pointer + 1) & 0x1F;}
+    return 1;
+}
+
+/************************************************
+ *  Function to return the next byte to the master
+ *  Reading CDATA latches all the data bytes, so a burst read is consistent
+ ***********************************************/
+static unsigned char tcsRead(void) {
+    unsigned char byte;
+    if (pointer == REG_CDATA) {
+        for (unsigned char i = 0; i < 8; i++) {latch[i] = regs[REG_CDATA + i];}
+    }
+    byte = pointer >= REG_CDATA && pointer < REG_CDATA + 8 ? latch[pointer - REG_CDATA] : regs[pointer];
+    if (autoIncrement) {pointer = (pointer + 1) & 0x1F;}
+    return byte;
+}
+
+/************************************************
+ *  Function to end a transaction on a stop condition
+ ***********************************************/
+static void tcsStop(void) {
+    command = 1;
+}
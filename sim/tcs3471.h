@@ -0,0 +1,25 @@
+#ifndef _tcs3471_H
+#define _tcs3471_H
+
+#include "mssp.h"
+
+/************************************************
+ *  Host model of the TCS3471 colour sensor on the colour click
+ *  Registers, command protocol, RGBC integration with gain and
+ *  saturation, the AINT status flag and the CDATA read latch
+ ***********************************************/
+
+#define TCS_ADDRESS 0x29        // 7 bit I2C address
+#define TCS_CYCLE_NS 2400000    // one integration cycle (ATIME step)
+#define TCS_ID 0x14             // ID register of the TCS34711/TCS34715
+
+extern I2C_SLAVE tcsSlave;                  // attach with msspAttach
+extern void (*tcsLight)(double crgb[4]);    // light reaching the sensor in data register order (c, r, g, b), counts per cycle at 1x gain
+extern double tcsNoise;                     // noise scale, 1 for the default shot and read noise
+extern unsigned long tcsIntegrations;       // integrations completed since tcsReset
+
+void tcsReset(unsigned long seed);
+void tcsStep(unsigned long ns);
+unsigned char tcsRegister(unsigned char address);
+
+#endif
@@ -0,0 +1,378 @@
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "i2c.h"
+#include "structures.h"
+#include "mssp.h"
+#include "tcs3471.h"
+#include "timers.h"
+
+/************************************************
+ *  Host test of the interrupt driven I2C transaction engine
+ *  i2c.c is built with -finstrument-functions, so every engine call advances
+ *  the MSSP2 model and busy waits such as I2C_2_Master_Transfer complete.
+ *  The TCS3471 model is the device on the bus, wrapped so a test can make it
+ *  refuse a byte. The calls also run the 1ms tick clock for the transfer timeout
+ ***********************************************/
+
+#define CALL_NS 1000                // bus time charged for each engine call
+#define STEP_LIMIT 100000           // service calls before a transaction is taken as hung
+#define TICK_NS 1000000             // tick clock period
+
+static unsigned int checks = 0, failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(int ok, const char *what, int line) {
+    checks++;
+    if (ok) {return;}
+    failures++;
+    printf("test_i2c.c:%d: check failed: %s\n", line, what);
+}
+
+#define CHECK_TRACE(expected) checkTrace((expected), __LINE__)
+
+static void checkTrace(const char *expected, int line) {
+    checks++;
+    if (!strcmp(msspTrace, expected)) {return;}
+    failures++;
+    printf("test_i2c.c:%d: bus trace \"%s\", expected \"%s\"\n", line, msspTrace, expected);
+}
+
+// device on the bus: the sensor model, refusing the nth byte written after its address
+static unsigned char refuseAt = 0;  // byte to refuse, 1 for the command byte (0: never)
+static unsigned char written;       // bytes written since the address
+
+static unsigned char deviceAddress(unsigned char byte) {
+    written = 0;
+    return tcsSlave.address(byte);
+}
+
+static unsigned char deviceWrite(unsigned char byte) {
+    if (++written == refuseAt) {return 0;}
+    return tcsSlave.write(byte);
+}
+
+static I2C_SLAVE device;
+
+// completion callbacks record the order they ran in and the outcome they saw
+static char order[16];
+static unsigned char failedSeen[4];
+
+static void callbackA(void) {failedSeen[0] = I2C_2_Master_Failed(); strcat(order, "A");}
+static void callbackB(void) {failedSeen[1] = I2C_2_Master_Failed(); strcat(order, "B");}
+static void callbackC(void) {failedSeen[2] = I2C_2_Master_Failed(); strcat(order, "C");}
+
+static unsigned char chainBuf;
+static void callbackChain(void) {   // queues a follow up from the completion, as color_status_done does
+    I2C_XFER xfer = {0x52, 0xA0 | 0x12, &chainBuf, 1, 1, 0, callbackC};
+    strcat(order, "Q");
+    I2C_2_Master_Queue(&xfer);
+}
+
+/************************************************
+ *  Function called on entry to every engine function, advances the bus
+ ***********************************************/
+static unsigned long tickNs = 0;    // bus time since the last tick
+
+void __cyg_profile_func_enter(void *fn, void *site) {
+    (void)fn; (void)site;
+    msspStep(CALL_NS);
+    tickNs += CALL_NS;
+    if (tickNs >= TICK_NS) {
+        tickNs -= TICK_NS;
+        clockTick();
+    }
+}
+
+void __cyg_profile_func_exit(void *fn, void *site) {
+    (void)fn; (void)site;
+}
+
+/************************************************
+ *  Function to service the engine, as the MSSP2 interrupt would, until the
+ *  queue is empty and the bus released
+ *  Returns 0 if the engine did not finish
+ ***********************************************/
+static unsigned char runEngine(void) {
+    for (unsigned long i = 0; i < STEP_LIMIT; i++) {
+        if (!I2C_2_Master_Busy() && msspIdle()) {return 1;}
+        I2C_2_Master_Service();
+    }
+    return 0;
+}
+
+/************************************************
+ *  Function to return the engine, bus and device to their power up state
+ ***********************************************/
+static void reset(void) {
+    runEngine();
+    msspReset();
+    tcsReset(1);
+    device = tcsSlave;
+    device.address = deviceAddress;
+    device.write = deviceWrite;
+    msspAttach(&device);
+    refuseAt = 0;
+    order[0] = 0;
+    memset(failedSeen, 0xFF, sizeof(failedSeen));
+}
+
+static I2C_XFER makeXfer(unsigned char command, unsigned char *data, unsigned char length, unsigned char read,
+                         volatile unsigned char *done, void (*callback)(void)) {
+    I2C_XFER xfer = {0x52, command, data, length, read, done, callback};
+    return xfer;
+}
+
+/************************************************
+ *  Write then read back a register: start, address, command, data, stop
+ ***********************************************/
+static void testWriteRead(void) {
+    reset();
+    volatile unsigned char done = 0x55;
+    unsigned char value = 0xD5, back[2] = {0, 0};
+
+    I2C_XFER w = makeXfer(0x80 | 0x01, &value, 1, 0, &done, callbackA);
+    CHECK(I2C_2_Master_Queue(&w));
+    CHECK(done == 0);                           // cleared when queued
+    CHECK(I2C_2_Master_Busy());
+    CHECK(runEngine());
+    CHECK(done == I2C_DONE_OK);
+    CHECK(failedSeen[0] == 0);
+    CHECK(tcsRegister(0x01) == 0xD5);
+    CHECK_TRACE("S W52+ W81+ WD5+ P");
+
+    msspReset();
+    I2C_XFER r = makeXfer(0xA0 | 0x01, back, 2, 1, &done, 0);
+    CHECK(I2C_2_Master_Queue(&r));
+    CHECK(runEngine());
+    CHECK(done == I2C_DONE_OK);
+    CHECK(back[0] == 0xD5 && back[1] == 0x00);  // ATIME then the reserved register after it
+    CHECK_TRACE("S W52+ WA1+ Sr W53+ RD5A R00N P");
+}
+
+/************************************************
+ *  Command only transaction, as the interrupt clear
+ ***********************************************/
+static void testCommandOnly(void) {
+    reset();
+    volatile unsigned char done = 0;
+    unsigned char unused = 0;
+
+    I2C_XFER x = makeXfer(0xE6, &unused, 0, 0, &done, 0);
+    CHECK(I2C_2_Master_Queue(&x));
+    CHECK(runEngine());
+    CHECK(done == I2C_DONE_OK);
+    CHECK_TRACE("S W52+ WE6+ P");
+}
+
+/************************************************
+ *  A device that does not acknowledge its address, the command byte or a
+ *  data byte: the engine stops at once, flags the failure and carries on
+ *  with the next transaction
+ ***********************************************/
+static void testNack(void) {
+    volatile unsigned char done[3];
+    unsigned char value = 0x12, buf[2] = {0xEE, 0xEE};
+
+    // no device at the address
+    reset();
+    I2C_XFER x = makeXfer(0x80 | 0x01, &value, 1, 0, &done[0], callbackA);
+    x.address = 0x60;
+    CHECK(I2C_2_Master_Queue(&x));
+    CHECK(runEngine());
+    CHECK(done[0] == I2C_DONE_NACK);
+    CHECK(failedSeen[0] == 1);
+    CHECK_TRACE("S W60- P");
+
+    // command byte refused, a read never reaches the repeated start
+    reset();
+    refuseAt = 1;
+    x = makeXfer(0xA0 | 0x12, buf, 2, 1, &done[0], callbackA);
+    CHECK(I2C_2_Master_Queue(&x));
+    CHECK(runEngine());
+    CHECK(done[0] == I2C_DONE_NACK);
+    CHECK(failedSeen[0] == 1);
+    CHECK(buf[0] == 0xEE && buf[1] == 0xEE);   // the buffer is untouched
+    CHECK_TRACE("S W52+ WB2- P");
+
+    // data byte refused part way through a write, the next transaction still runs
+    reset();
+    refuseAt = 3;
+    unsigned char data[3] = {0x11, 0x22, 0x33};
+    I2C_XFER two[2];
+    two[0] = makeXfer(0xA0 | 0x01, data, 3, 0, &done[0], callbackA);
+    two[1] = makeXfer(0x80 | 0x12, buf, 1, 1, &done[1], callbackB);
+    CHECK(I2C_2_Master_QueueAll(two, 2));
+    CHECK(runEngine());
+    CHECK(done[0] == I2C_DONE_NACK);
+    CHECK(done[1] == I2C_DONE_OK);
+    CHECK(failedSeen[0] == 1 && failedSeen[1] == 0);   // the failure does not carry over
+    CHECK(!strcmp(order, "AB"));
+    CHECK(buf[0] == TCS_ID);
+    CHECK_TRACE("S W52+ WA1+ W11+ W22- P S W52+ W92+ Sr W53+ R14N P");
+}
+
+/************************************************
+ *  Queue full: one slot is kept empty, and a group is queued whole or not at all
+ ***********************************************/
+static void testQueueFull(void) {
+    reset();
+    volatile unsigned char done[I2C_QUEUE_SIZE + 2];
+    unsigned char buf[I2C_QUEUE_SIZE + 2];
+    void (*callbacks[3])(void) = {callbackA, callbackB, callbackC};
+    I2C_XFER x[I2C_QUEUE_SIZE + 2];
+
+    for (unsigned char i = 0; i < I2C_QUEUE_SIZE + 2; i++) {
+        done[i] = 0x55;
+        x[i] = makeXfer(0xA0 | 0x12, &buf[i], 1, 1, &done[i], i < 3 ? callbacks[i] : 0);
+    }
+
+    // the bus is not serviced, so nothing completes while the queue fills
+    for (unsigned char i = 0; i < I2C_QUEUE_SIZE - 1; i++) {CHECK(I2C_2_Master_Queue(&x[i]));}
+    CHECK(!I2C_2_Master_Queue(&x[I2C_QUEUE_SIZE - 1]));
+    CHECK(done[I2C_QUEUE_SIZE - 1] == 0x55);           // a rejected transaction is not touched
+    CHECK(PIE3bits.SSP2IE);                             // the engine is released on the full path too
+    CHECK(runEngine());
+    CHECK(!strcmp(order, "ABC"));
+    for (unsigned char i = 0; i < I2C_QUEUE_SIZE - 1; i++) {CHECK(done[i] == I2C_DONE_OK && buf[i] == TCS_ID);}
+    CHECK(done[I2C_QUEUE_SIZE - 1] == 0x55);
+
+    // with one slot left a pair is refused whole
+    reset();
+    CHECK(I2C_2_Master_Queue(&x[0]));
+    CHECK(I2C_2_Master_Queue(&x[1]));
+    CHECK(!I2C_2_Master_QueueAll(&x[4], 2));
+    CHECK(done[4] == 0x55 && done[5] == 0x55);
+    CHECK(runEngine());
+    CHECK_TRACE("S W52+ WB2+ Sr W53+ R14N P S W52+ WB2+ Sr W53+ R14N P");
+
+    // once drained the pair fits
+    CHECK(I2C_2_Master_QueueAll(&x[4], 2));
+    CHECK(runEngine());
+    CHECK(done[4] == I2C_DONE_OK && done[5] == I2C_DONE_OK);
+}
+
+/************************************************
+ *  A completion callback queuing the next transaction, as the background sampler does
+ ***********************************************/
+static void testCallbackQueues(void) {
+    reset();
+    volatile unsigned char done = 0;
+    unsigned char status = 0;
+    chainBuf = 0;
+
+    I2C_XFER x = makeXfer(0xA0 | 0x13, &status, 1, 1, &done, callbackChain);
+    CHECK(I2C_2_Master_Queue(&x));
+    CHECK(runEngine());
+    CHECK(!strcmp(order, "QC"));
+    CHECK(chainBuf == TCS_ID);
+    CHECK(failedSeen[2] == 0);
+}
+
+/************************************************
+ *  The blocking wrapper returns the outcome and leaves the caller's done flag set
+ ***********************************************/
+static void testTransfer(void) {
+    reset();
+    volatile unsigned char done = 0;
+    unsigned char id = 0;
+
+    I2C_XFER x = makeXfer(0xA0 | 0x12, &id, 1, 1, &done, 0);
+    CHECK(I2C_2_Master_Transfer(&x));
+    CHECK(id == TCS_ID);
+    CHECK(done == I2C_DONE_OK);
+    CHECK(x.done == &done);
+
+    reset();
+    x.address = 0x60;
+    CHECK(!I2C_2_Master_Transfer(&x));
+    CHECK(done == I2C_DONE_NACK);
+    CHECK(!I2C_2_Master_Busy());
+}
+
+/************************************************
+ *  A read of no bytes is refused before anything is queued
+ ***********************************************/
+static void testZeroRead(void) {
+    reset();
+    volatile unsigned char done = 0x55;
+    unsigned char buf[1] = {0xEE};
+    I2C_XFER x[2];
+    x[0] = makeXfer(0xA0 | 0x12, buf, 1, 1, 0, 0);
+    x[1] = makeXfer(0xA0 | 0x12, buf, 0, 1, &done, 0);
+
+    CHECK(!I2C_2_Master_Queue(&x[1]));
+    CHECK(!I2C_2_Master_QueueAll(x, 2));            // the whole group is refused
+    CHECK(done == 0x55);
+    CHECK(!I2C_2_Master_Busy());
+    CHECK(buf[0] == 0xEE);
+    CHECK_TRACE("");
+}
+
+/************************************************
+ *  Another master wins the bus: the transaction completes as failed and the
+ *  next one still runs
+ ***********************************************/
+static void testCollision(void) {
+    reset();
+    volatile unsigned char done[2];
+    unsigned char buf[2] = {0xEE, 0xEE};
+    I2C_XFER two[2];
+    two[0] = makeXfer(0xA0 | 0x12, &buf[0], 1, 1, &done[0], callbackA);
+    two[1] = makeXfer(0xA0 | 0x12, &buf[1], 1, 1, &done[1], callbackB);
+
+    msspCollide = 1;
+    CHECK(I2C_2_Master_QueueAll(two, 2));
+    CHECK(runEngine());
+    CHECK(done[0] == I2C_DONE_ERROR && done[1] == I2C_DONE_OK);
+    CHECK(failedSeen[0] == 1 && failedSeen[1] == 0);
+    CHECK(!strcmp(order, "AB"));
+    CHECK(buf[0] == 0xEE && buf[1] == TCS_ID);
+    CHECK(!PIR3bits.BCL2IF);
+    CHECK_TRACE("C S W52+ WB2+ Sr W53+ R14N P");
+}
+
+/************************************************
+ *  A bus that never completes an action: Transfer gives up after
+ *  I2C_TIMEOUT, fails everything queued and leaves the engine usable
+ ***********************************************/
+static void testStuckBus(void) {
+    reset();
+    volatile unsigned char done = 0;
+    unsigned char id = 0, other = 0xEE;
+    I2C_XFER queued = makeXfer(0xA0 | 0x12, &other, 1, 1, 0, callbackA);
+    I2C_XFER x = makeXfer(0xA0 | 0x12, &id, 1, 1, &done, 0);
+
+    msspStuck = 1;
+    CHECK(I2C_2_Master_Queue(&queued));
+    unsigned long start = getTicks();
+    CHECK(!I2C_2_Master_Transfer(&x));
+    unsigned long waited = ticksSince(start);
+    CHECK(waited >= I2C_TIMEOUT && waited <= I2C_TIMEOUT + 2);
+    CHECK(done == I2C_DONE_ERROR);
+    CHECK(failedSeen[0] == 1 && other == 0xEE);
+    CHECK(!I2C_2_Master_Busy());
+    CHECK(SSP2CON2 == 0);                           // no condition left pending
+
+    // the restarted module has released the bus, the next transfer goes through
+    msspReset();
+    CHECK(I2C_2_Master_Transfer(&x));
+    CHECK(id == TCS_ID && done == I2C_DONE_OK);
+}
+
+int main(void) {
+    I2C_2_Master_Init();
+    testWriteRead();
+    testCommandOnly();
+    testNack();
+    testQueueFull();
+    testCallbackQueues();
+    testTransfer();
+    testZeroRead();
+    testCollision();
+    testStuckBus();
+
+    printf("test_i2c: %u checks, %u failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
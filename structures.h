@@ -1,7 +1,7 @@
 #ifndef _structures_H
 #define _structures_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define _XTAL_FREQ 64000000
 
@@ -12,6 +12,22 @@ typedef struct RGB {          // definition of RGB structure
     unsigned int c;           // clear value
 } RGB;
 
+#define FILTER_SIZE 8         // samples kept in the filter ring (power of two)
+#define FILTER_WINDOW 4       // samples in the moving average (less than FILTER_SIZE)
+
+typedef struct SAMPLE {       // definition of timestamped SAMPLE structure
+    RGB rgb;                  // raw RGBC reading
+    unsigned long time;       // tick count when the sample was collected
+    unsigned int meanC;       // moving average of the clear channel up to this sample
+} SAMPLE;
+
+typedef struct FILTER {         // definition of sample FILTER structure
+    SAMPLE ring[FILTER_SIZE];   // most recent samples, the oldest is overwritten first
+    unsigned char head;         // index the next sample is written to
+    unsigned char count;        // number of samples held (up to FILTER_SIZE)
+    unsigned long sum[4];       // running r, g, b, c sums over the moving average window
+} FILTER;
+
 typedef struct HSV {          // definition of HSV structure
     unsigned int h;           // hue value
     unsigned int s;           // saturation value
@@ -19,34 +35,105 @@ typedef struct HSV {          // definition of HSV structure
     unsigned int c;           // clear value
 } HSV;
 
-typedef struct MOVE {         // definition of MOVE structure
-    unsigned char type;       // 0/1: straight/rotate
-    unsigned char direction;  // 0/1: backward/forward | 0/1: left/right 
-    unsigned char power;      // power of straight | angle of rotate
-    unsigned int time;        // time taken for move
+#define SEQUENCE_MAX 80       // number of moves the sequence can remember
+
+typedef struct MOVE {         // definition of packed MOVE structure
+    unsigned char code;       // bit 7: straight/rotate | bit 6: backward/forward or left/right | bits 0-5: power/2 or angle/45
+    unsigned int distance;    // distance of a straight move in odometer steps (unused for rotations)
 } MOVE;
 
 typedef struct SEQUENCE {     // definition of SEQUENCE structure
-    unsigned int index;       // counter of number of moves remembered
-    MOVE moves[50];           // array of MOVE structures remembered
+    unsigned char index;      // counter of number of moves remembered
+    MOVE moves[SEQUENCE_MAX]; // array of packed MOVE structures remembered
 } SEQUENCE;
 
+#define MAP_SIZE 16           // cells along each side of the map, the start is in the middle
+
+typedef struct MAP {          // definition of grid MAP structure
+    unsigned char open[MAP_SIZE * MAP_SIZE / 2];    // bit packed passages driven, 4 bits per cell (N, NE, E, SE)
+    unsigned char x, y;       // current cell
+    unsigned char heading;    // current heading in 45 degree steps clockwise from the start heading
+    unsigned char valid;      // cleared if the buggy left the map or the map has been used
+    unsigned int travelled;   // cells driven since the start
+} MAP;
+
+typedef struct CLASSIFIER {   // definition of CLASSIFIER structure
+    unsigned int cent[9][4];  // normalised h, s, v, c centroid of each calibration card
+    unsigned int weight[4];   // 8.8 fixed point weight of each channel
+    long offset[4];           // offset removed from each channel before weighting
+    unsigned int hueCircle;   // normalised length of a full hue circle
+    unsigned int nearest[9];  // distance from each centroid to its nearest neighbour
+} CLASSIFIER;
+
 typedef struct DATA {         // definition of overall DATA structure
     HSV cal[9];               // nested structure to store calibration data
+    RGB rgb;                  // nested structure to store instantaneous raw sample
     HSV hsv;                  // nested structure to store instantaneous color
     unsigned int ambLight;    // integer to store clear channel data for wall detection
     unsigned char backtrack;  // variable to store if the backtrack functionality is to be executed
     unsigned char count;      // variable to count the number of failed color detections
+    unsigned int margin;      // confidence margin of the last color detection
+    unsigned char decision;   // class of the sample in hsv (0xFF if it was not classified)
     SEQUENCE *sequence;       // nested structure to store the sequence of moves
+    CLASSIFIER *classifier;   // nested structure to store the precomputed classifier
+    FILTER *filter;           // nested structure to store the filtered sample stream
+    MAP *map;                 // nested structure to store the grid map of the mine
 } DATA;
 
+typedef struct I2C_XFER {               // definition of queued I2C transaction
+    unsigned char address;              // 7 bit device address with R/W bit clear
+    unsigned char command;              // command/register byte sent after the address
+    unsigned char *data;                // buffer to write from or read into
+    unsigned char length;               // number of data bytes to transfer
+    unsigned char read;                 // 0/1: write/read transaction
+    volatile unsigned char *done;       // flag set to I2C_DONE_OK or I2C_DONE_NACK on completion (optional)
+    void (*callback)(void);             // function called on completion (optional)
+} I2C_XFER;
+
+typedef struct TURN_TABLE {    // definition of TURN_TABLE structure
+    unsigned int hold[2][4];   // full power hold time (ms) per direction (left/right) and angle (45/90/135/180)
+} TURN_TABLE;
+
+typedef struct TASK {           // definition of scheduled TASK structure
+    void (*run)(void);          // task function, must return without blocking
+    unsigned int period;        // ticks (ms) between runs
+    unsigned long next;         // tick count of the next run
+} TASK;
+
+typedef struct PROFILE {       // definition of PROFILE structure
+    unsigned int count;        // number of times the section has run (saturates)
+    unsigned long min;         // shortest run in instruction cycles
+    unsigned long max;         // longest run in instruction cycles
+    unsigned long total;       // sum of all runs, mean = total / count
+} PROFILE;
+
+typedef struct MOTOR_TRIM {    // definition of MOTOR_TRIM structure
+    unsigned int gain[2];      // 8.8 fixed point gain of the left and right motor at full power (256 = 1)
+    unsigned char offset[2];   // power of the left and right motor at the bottom of the range, for the deadband
+} MOTOR_TRIM;
+
+typedef struct ODOMETER {       // definition of wheel ODOMETER structure
+    volatile int speed;         // modelled wheel speed, power x 256 (forward positive)
+    volatile unsigned long count;   // distance travelled, power x ms x 256 (wraps, use differences)
+} ODOMETER;
+
+#define MOTOR_MAX 100                   // full motor power
+#define POWER_SHIFT 8                   // fractional bits of the fixed point motor power
+
 typedef struct DC_motor {           // definition of DC_motor structure
-    char power;                     // motor power, out of 100
-    char direction;                 // motor direction, forward(1), reverse(0)
+    volatile unsigned int power;    // motor power, 8.8 fixed point out of 100
+    volatile char direction;        // motor direction, forward(1), reverse(0)
+    volatile unsigned int targetPower;  // power the motor task is ramping to (8.8 fixed point)
+    volatile char targetDirection;  // direction the motor task is ramping to
+    unsigned int accel;             // power increase per control tick (8.8 fixed point)
+    unsigned int decel;             // power decrease per control tick (8.8 fixed point)
     char brakemode;		            // short or fast decay (brake or coast)
-    unsigned int PWMperiod;         // base period of PWM cycle
-    unsigned char *posDutyHighByte; // PWM duty address for motor +ve side
-    unsigned char *negDutyHighByte; // PWM duty address for motor -ve side
+    unsigned int PWMperiod;         // base period of PWM cycle in 10 bit duty counts
+    unsigned char *posDutyLowByte;  // PWM duty low byte address for motor +ve side
+    unsigned char *posDutyHighByte; // PWM duty high byte address for motor +ve side
+    unsigned char *negDutyLowByte;  // PWM duty low byte address for motor -ve side
+    unsigned char *negDutyHighByte; // PWM duty high byte address for motor -ve side
+    unsigned int duty[MOTOR_MAX + 1];   // trimmed PWM duty for each whole power, built by motorTable
 } DC_MOTOR;
 
 #endif
@@ -0,0 +1,75 @@
+#include "hal.h"
+#include "color.h"
+#include "dc_motor.h"
+#include "serial.h"
+#include "structures.h"
+#include "telemetry.h"
+#include "timers.h"
+
+/************************************************
+ *  Function to queue a binary frame on the serial link without blocking
+ *  Frame: sync1, sync2, type, length, payload, checksum
+ *  The checksum makes the byte sum from type to checksum zero
+ *  1: frame queued
+ *  0: frame dropped because the TX buffer was too full
+ ***********************************************/
+unsigned char telemetrySend(unsigned char type, unsigned char *payload, unsigned char length) {
+    unsigned char frame[4 + TELEMETRY_MAX_LEN + 1];
+    unsigned char sum = type + length;
+    
+    if (length > TELEMETRY_MAX_LEN) {return 0;}
+    
+    frame[0] = TELEMETRY_SYNC1;
+    frame[1] = TELEMETRY_SYNC2;
+    frame[2] = type;
+    frame[3] = length;
+    for (unsigned char i = 0; i < length; i++) {
+        frame[4 + i] = payload[i];
+        sum += payload[i];
+    }
+    frame[4 + length] = -sum;
+    
+    if (!TxBufferedBytes(frame, length + 5)) {return 0;}
+    sendTxBuf();    // start the TX interrupt if it has drained
+    return 1;
+}
+
+/************************************************
+ *  Function to pack a 16 bit value little endian
+ ***********************************************/
+static unsigned char *put16(unsigned char *p, unsigned int value) {
+    *p++ = value & 0xFF;
+    *p++ = value >> 8;
+    return p;
+}
+
+/************************************************
+ *  Function to send the colour sample in data, its class and the motor state
+ *  Payload (little endian): seq, ms timestamp (4), r, g, b, c, h, s, v (2 each),
+ *  class, margin (2), left power, right power, directions (bit 0 left, bit 1 right),
+ *  frames dropped so far (2)
+ ***********************************************/
+void telemetrySample(DATA *data) {
+    unsigned char payload[TELEMETRY_SAMPLE_LEN];
+    unsigned char *p = payload;
+    unsigned long now = getTicks();
+    
+    *p++ = color_sample_seq();
+    p = put16(p, now & 0xFFFF);
+    p = put16(p, now >> 16);
+    p = put16(p, data->rgb.r);
+    p = put16(p, data->rgb.g);
+    p = put16(p, data->rgb.b);
+    p = put16(p, data->rgb.c);
+    p = put16(p, data->hsv.h);
+    p = put16(p, data->hsv.s);
+    p = put16(p, data->hsv.v);
+    *p++ = data->decision;
+    p = put16(p, data->decision == TELEMETRY_NO_CLASS ? 0 : data->margin);
+    *p++ = motorPower(&motorL) >> POWER_SHIFT;
+    *p++ = motorPower(&motorR) >> POWER_SHIFT;
+    *p++ = (motorL.direction ? 0x01 : 0) | (motorR.direction ? 0x02 : 0);
+    put16(p, TxBufDropped);
+    
+    telemetrySend(TELEMETRY_SAMPLE, payload, TELEMETRY_SAMPLE_LEN);
+}
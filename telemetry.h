@@ -0,0 +1,21 @@
+#ifndef _telemetry_H
+#define _telemetry_H
+
+#include "hal.h"
+#include "structures.h"
+
+#define _XTAL_FREQ 64000000
+
+#define TELEMETRY_SYNC1 0xAA        // first byte of every frame
+#define TELEMETRY_SYNC2 0x55        // second byte of every frame
+#define TELEMETRY_MAX_LEN 32        // largest payload of any frame
+#define TELEMETRY_SAMPLE 0x01       // frame type of a colour sample
+#define TELEMETRY_SAMPLE_LEN 27     // payload bytes of a colour sample frame
+#define TELEMETRY_PROFILE 0x02      // frame type of a profiled section
+#define TELEMETRY_PROFILE_LEN 15    // payload bytes of a profiled section frame
+#define TELEMETRY_NO_CLASS 0xFF     // class sent for samples that were not classified
+
+void telemetrySample(DATA *data);
+unsigned char telemetrySend(unsigned char type, unsigned char *payload, unsigned char length);
+
+#endif
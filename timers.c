@@ -1,6 +1,8 @@
-#include <xc.h>
+#include "hal.h"
 #include "timers.h"
 
+static volatile unsigned long ticks = 0;   // free running 1ms tick count, wraps after 49.7 days
+
 /************************************
  * Function to set up timer 0
 ************************************/
@@ -16,22 +18,56 @@ void Timer0_init(void) {
 }
 
 /************************************
- * Function to reset the timer
+ * Function to set up timer 4 as the 1ms control tick
 ************************************/
-void resetTimer(void) {
-	TMR0H = 0;
-    TMR0L = 0; 
+void Timer4_init(void) {
+    T4CLKCONbits.CS = 0b0001;     // Fosc/4
+    T4CONbits.CKPS = 0b111;       // 1:128 prescaler, 125kHz count rate
+    T4HLTbits.MODE = 0b00000;     // free running mode, software gate only
+    T4PR = 124;                   // 125 counts per period = 1ms
+    T4CONbits.ON = 1;             // start the timer
 }
 
 /************************************
- * Function to return the full 16bit timer value
- * Note TMR0L and TMR0H must be read in the correct order, or TMR0H will not contain the correct value
+ * Function to advance the tick clock, called from the timer 4 interrupt
 ************************************/
-unsigned int get16bitTMR0val(void) {
-	// must ensure each register is read as an unsigned int for correct functionality
-    unsigned int timer_l = TMR0L;
-    unsigned int timer_h = TMR0H;
-    
-    return timer_l | timer_h << 8; // TMR0L for bits 0 - 7 and TMR0H for bits 8-15
+void clockTick(void) {
+    ticks++;
 }
 
+/************************************
+ * Function to return the 32bit tick count
+ * The count is read again until it is unchanged, so an interrupt
+ * mid-read can never return a torn value
+************************************/
+unsigned long getTicks(void) {
+    unsigned long t;
+    do {
+        t = ticks;
+    } while (t != ticks);
+    return t;
+}
+
+/************************************
+ * Function to return the ticks elapsed since a previous tick count
+ * Unsigned subtraction keeps the result correct across a wrap
+************************************/
+unsigned long ticksSince(unsigned long start) {
+    return getTicks() - start;
+}
+
+/************************************
+ * Function to check if a deadline has been reached
+ * 1: deadline reached or passed
+ * 0: deadline still in the future
+************************************/
+unsigned char deadlineReached(unsigned long deadline) {
+    return (long)(getTicks() - deadline) >= 0;
+}
+
+/************************************
+ * Function to wait until a deadline has been reached
+************************************/
+void waitUntil(unsigned long deadline) {
+    while (!deadlineReached(deadline)) {}
+}
@@ -1,12 +1,16 @@
 #ifndef _timers_H
 #define _timers_H
 
-#include <xc.h>
+#include "hal.h"
 
 #define _XTAL_FREQ 64000000
 
 void Timer0_init(void);
-void resetTimer(void);
-unsigned int get16bitTMR0val(void);
+void Timer4_init(void);
+void clockTick(void);
+unsigned long getTicks(void);
+unsigned long ticksSince(unsigned long start);
+unsigned char deadlineReached(unsigned long deadline);
+void waitUntil(unsigned long deadline);
 
 #endif